@@ -0,0 +1,283 @@
+#pragma once
+
+#include "pch.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//Small benchmark harness: timing, hardware counters, throughput reporting and an optimization barrier
+
+namespace Bench
+{
+	using Clock = std::chrono::steady_clock;
+
+	//Keep the compiler from optimizing away a computed value
+	template<typename T>
+	void DoNotOptimize(T const& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r"(&value) : "memory");
+#else
+		static void const* volatile sink{ nullptr };
+		sink = &value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+	}
+
+	//Run setup (untimed) and fn (timed) repetitions times and return the best run in nanoseconds
+	template<typename Setup, typename Fn>
+	double Measure(Setup&& setup, Fn&& fn, int const repetitions = 5)
+	{
+		double best{ std::numeric_limits<double>::max() };
+		for (int i = 0; i < repetitions; ++i)
+		{
+			setup();
+			auto const start{ Clock::now() };
+			fn();
+			auto const stop{ Clock::now() };
+			best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count());
+		}
+		return best;
+	}
+
+	template<typename Fn>
+	double Measure(Fn&& fn, int const repetitions = 5)
+	{
+		return Measure([] {}, std::forward<Fn>(fn), repetitions);
+	}
+
+	//Print one result line: name, time and (if bytes is given) throughput
+	inline void Report(std::string_view const name, double const nanoseconds, std::size_t const bytes = 0)
+	{
+		std::cout << std::format("  {:<40} {:>12.3f} ms", name, nanoseconds / 1e6);
+		if (bytes > 0)
+			std::cout << std::format("  {:>8.2f} GB/s", bytes / nanoseconds);
+		std::cout << std::endl;
+	}
+
+	namespace Detail
+	{
+		inline std::atomic<std::size_t> FailedChecks{ 0 };
+	}
+
+	//Verify a result of a benchmark. Unlike assert this also runs in Release builds, where the benchmarks are meant to run:
+	//a failure is printed and counted, and the benchmark run ends with an error (see FailedChecks).
+	inline void Check(bool const passed, std::string_view const what, std::source_location const location = std::source_location::current())
+	{
+		if (passed)
+			return;
+		++Detail::FailedChecks;
+		std::cout << std::format("  CHECK FAILED: {} ({}:{})", what, location.file_name(), location.line()) << std::endl;
+	}
+
+	//Number of failed checks so far
+	inline std::size_t FailedChecks() noexcept
+	{
+		return Detail::FailedChecks.load();
+	}
+
+	//Print the speedup of a fast path compared to its baseline
+	inline void ReportSpeedup(std::string_view const name, double const baselineNanoseconds, double const fastNanoseconds)
+	{
+		std::cout << std::format("  {:<40} {:>12.2f}x", name, baselineNanoseconds / fastNanoseconds) << std::endl;
+	}
+
+	//Time fn(i) for every i in [0, count) on its own and return the single latencies in nanoseconds
+	template<typename Fn>
+	std::vector<double> MeasureLatencies(std::size_t const count, Fn&& fn)
+	{
+		std::vector<double> latencies(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			auto const start{ Clock::now() };
+			fn(i);
+			latencies[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		}
+		return latencies;
+	}
+
+	//Print the median, 99th percentile and maximum of single latencies
+	inline void ReportLatencies(std::string_view const name, std::vector<double> latencies)
+	{
+		if (latencies.empty())
+			return;
+		auto const percentile = [&](double const p) {
+			auto const nth{ latencies.begin() + static_cast<std::ptrdiff_t>(p * static_cast<double>(latencies.size() - 1)) };
+			std::nth_element(latencies.begin(), nth, latencies.end());
+			return *nth / 1e3;
+		};
+		double const p50{ percentile(0.5) };
+		double const p99{ percentile(0.99) };
+		double const max{ percentile(1.0) };
+		std::cout << std::format("  {:<40} p50 {:>8.2f} us  p99 {:>8.2f} us  max {:>8.2f} us", name, p50, p99, max) << std::endl;
+	}
+
+	//Vector of count uniformly distributed random numbers in [low, high]
+	template<typename T>
+	std::vector<T> RandomVector(std::size_t const count, T const low, T const high, std::uint32_t const seed = 42)
+	{
+		std::mt19937_64 engine{ seed };
+		std::vector<T> v(count);
+		if constexpr (std::floating_point<T>)
+		{
+			std::uniform_real_distribution<T> distribution{ low, high };
+			std::generate(v.begin(), v.end(), [&] { return distribution(engine); });
+		}
+		else
+		{
+			std::uniform_int_distribution<T> distribution{ low, high };
+			std::generate(v.begin(), v.end(), [&] { return distribution(engine); });
+		}
+		return v;
+	}
+
+	//Hardware events that PerfCounter can count
+	enum class PerfEvent
+	{
+		DtlbLoadMisses,
+		CacheMisses,
+		BranchMisses,
+		Instructions
+	};
+
+	//Counts a hardware event of the calling thread with perf_event_open (Linux only).
+	//Available() is false if the platform or the kernel (perf_event_paranoid, virtual machines) does not allow it.
+	class PerfCounter
+	{
+	public:
+		explicit PerfCounter(PerfEvent const event)
+		{
+#if defined(__linux__)
+			perf_event_attr attributes{};
+			attributes.size = sizeof(attributes);
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			switch (event)
+			{
+			case PerfEvent::DtlbLoadMisses:
+				attributes.type = PERF_TYPE_HW_CACHE;
+				attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+				break;
+			case PerfEvent::CacheMisses:
+				attributes.type = PERF_TYPE_HARDWARE;
+				attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+				break;
+			case PerfEvent::BranchMisses:
+				attributes.type = PERF_TYPE_HARDWARE;
+				attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+				break;
+			case PerfEvent::Instructions:
+				attributes.type = PERF_TYPE_HARDWARE;
+				attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+				break;
+			}
+			_Fd = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+			(void)event;
+#endif
+		}
+
+		~PerfCounter()
+		{
+#if defined(__linux__)
+			if (_Fd >= 0)
+				::close(_Fd);
+#endif
+		}
+
+		PerfCounter(PerfCounter const&) = delete;
+		PerfCounter& operator=(PerfCounter const&) = delete;
+
+		bool Available() const noexcept
+		{
+			return _Fd >= 0;
+		}
+
+		void Start() noexcept
+		{
+#if defined(__linux__)
+			if (Available())
+			{
+				::ioctl(_Fd, PERF_EVENT_IOC_RESET, 0);
+				::ioctl(_Fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		//Stop counting and return the number of events since Start()
+		std::uint64_t Stop() noexcept
+		{
+			std::uint64_t value{ 0 };
+#if defined(__linux__)
+			if (Available())
+			{
+				::ioctl(_Fd, PERF_EVENT_IOC_DISABLE, 0);
+				if (::read(_Fd, &value, sizeof(value)) != sizeof(value))
+					value = 0;
+			}
+#endif
+			return value;
+		}
+
+	private:
+		int _Fd{ -1 };
+	};
+
+	//Run setup (not counted) and fn once and return the number of events in fn, or nothing if counting is unavailable
+	template<typename Setup, typename Fn>
+	std::optional<std::uint64_t> Count(PerfEvent const event, Setup&& setup, Fn&& fn)
+	{
+		PerfCounter counter{ event };
+		if (not counter.Available())
+			return std::nullopt;
+		setup();
+		counter.Start();
+		fn();
+		return counter.Stop();
+	}
+
+	//Print one counter line, or "n/a" if the counter was unavailable
+	inline void ReportCount(std::string_view const name, std::optional<std::uint64_t> const count)
+	{
+		if (count)
+			std::cout << std::format("  {:<40} {:>12}", name, *count) << std::endl;
+		else
+			std::cout << std::format("  {:<40} {:>12}", name, "n/a") << std::endl;
+	}
+
+	//Number of allocations made through any CountingAllocator
+	inline std::atomic<std::size_t> AllocationCount{ 0 };
+
+	//std::allocator that counts its allocations in AllocationCount
+	template<typename T>
+	struct CountingAllocator
+	{
+		using value_type = T;
+
+		CountingAllocator() noexcept = default;
+		template<typename U>
+		CountingAllocator(CountingAllocator<U> const&) noexcept {}
+
+		T* allocate(std::size_t const count)
+		{
+			AllocationCount.fetch_add(1, std::memory_order_relaxed);
+			return std::allocator<T>{}.allocate(count);
+		}
+
+		void deallocate(T* pointer, std::size_t const count) noexcept
+		{
+			std::allocator<T>{}.deallocate(pointer, count);
+		}
+
+		template<typename U>
+		bool operator==(CountingAllocator<U> const&) const noexcept
+		{
+			return true;
+		}
+	};
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "pch.h"
+
+//Helpers for bitmaps stored in 64 bit words (bit i lives in word i / 64 at position i % 64)
+
+namespace Bits
+{
+	//Mask with the lowest count bits set (count <= 64)
+	constexpr std::uint64_t LowMask(unsigned const count) noexcept
+	{
+		return count >= 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << count) - 1;
+	}
+
+	//Gather the bits of value selected by mask into the low bits of the result (PEXT)
+	inline std::uint64_t ParallelExtract(std::uint64_t const value, std::uint64_t mask) noexcept
+	{
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+		return _pext_u64(value, mask);
+#else
+		std::uint64_t result{ 0 };
+		for (unsigned position = 0; mask != 0; mask &= mask - 1, ++position)
+			result |= ((value >> std::countr_zero(mask)) & 1) << position;
+		return result;
+#endif
+	}
+
+	//Position of the set bit with the given rank (0-based) in value; value must have more than rank set bits
+	inline unsigned SelectInWord(std::uint64_t value, unsigned const rank) noexcept
+	{
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+		return static_cast<unsigned>(std::countr_zero(_pdep_u64(std::uint64_t{ 1 } << rank, value)));
+#else
+		for (unsigned i = 0; i < rank; ++i)
+			value &= value - 1;
+		return static_cast<unsigned>(std::countr_zero(value));
+#endif
+	}
+
+	//Number of words needed for count bits
+	constexpr std::size_t WordCount(std::size_t const count) noexcept
+	{
+		return (count + 63) / 64;
+	}
+
+	inline bool Get(std::span<std::uint64_t const> const words, std::size_t const position) noexcept
+	{
+		return (words[position / 64] >> (position % 64)) & 1;
+	}
+
+	inline void Set(std::span<std::uint64_t> const words, std::size_t const position, bool const value) noexcept
+	{
+		std::uint64_t const bit{ std::uint64_t{ 1 } << (position % 64) };
+		words[position / 64] = value ? (words[position / 64] | bit) : (words[position / 64] & ~bit);
+	}
+
+	//Read count (<= 64) bits starting at position
+	inline std::uint64_t Read(std::span<std::uint64_t const> const words, std::size_t const position, unsigned const count) noexcept
+	{
+		if (count == 0)
+			return 0;
+		std::size_t const word{ position / 64 };
+		unsigned const shift{ static_cast<unsigned>(position % 64) };
+		std::uint64_t value{ words[word] >> shift };
+		if (shift != 0 and shift + count > 64)
+			value |= words[word + 1] << (64 - shift);
+		return value & LowMask(count);
+	}
+
+	//Write the low count (<= 64) bits of value starting at position
+	inline void Write(std::span<std::uint64_t> const words, std::size_t const position, std::uint64_t value, unsigned const count) noexcept
+	{
+		if (count == 0)
+			return;
+		value &= LowMask(count);
+		std::size_t const word{ position / 64 };
+		unsigned const shift{ static_cast<unsigned>(position % 64) };
+		words[word] = (words[word] & ~(LowMask(count) << shift)) | (value << shift);
+		if (shift != 0 and shift + count > 64)
+		{
+			unsigned const rest{ shift + count - 64 };
+			words[word + 1] = (words[word + 1] & ~LowMask(rest)) | (value >> (64 - shift));
+		}
+	}
+
+	//Copy count bits from source position to target position, 64 bits per step.
+	//Source and target may be the same bitmap if targetPosition <= sourcePosition.
+	inline void Copy(std::span<std::uint64_t const> const source, std::size_t sourcePosition,
+		std::span<std::uint64_t> const target, std::size_t targetPosition, std::size_t count) noexcept
+	{
+		while (count > 0)
+		{
+			unsigned const step{ static_cast<unsigned>(std::min<std::size_t>(count, 64)) };
+			Write(target, targetPosition, Read(source, sourcePosition, step), step);
+			sourcePosition += step;
+			targetPosition += step;
+			count -= step;
+		}
+	}
+
+	//Same as std::rotate for the bits [first, last): the bit at middle becomes the bit at first
+	inline void Rotate(std::span<std::uint64_t> const words, std::size_t const first, std::size_t const middle, std::size_t const last)
+	{
+		std::size_t const headCount{ middle - first };
+		std::vector<std::uint64_t> head(WordCount(headCount));
+		Copy(words, first, head, 0, headCount);
+		Copy(words, middle, words, first, last - middle);
+		Copy(head, 0, words, first + (last - middle), headCount);
+	}
+}
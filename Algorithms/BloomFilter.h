@@ -0,0 +1,69 @@
+#pragma once
+
+#include "pch.h"
+#include "Hash.h"
+
+//Blocked Bloom filter: all bits of a key live in one 64 byte block, so a lookup costs a single cache miss.
+//No false negatives; with 10 bits per key the false positive rate is about 1%.
+
+namespace Filters
+{
+	class BloomFilter
+	{
+	public:
+		explicit BloomFilter(std::size_t const expectedCount, double const bitsPerKey = 10.0)
+			: _Blocks(std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(static_cast<double>(expectedCount) * bitsPerKey / BlockBits)))),
+			_HashCount{ std::clamp(static_cast<unsigned>(std::lround(bitsPerKey * 0.6931)), 1u, 16u) } //k = bits per key * ln 2
+		{
+		}
+
+		void AddHash(std::uint64_t const hash) noexcept
+		{
+			auto& words{ _Blocks[BlockIndex(hash)].Words };
+			std::uint64_t bits{ Hashing::Mix64(hash) };
+			for (unsigned i = 0; i < _HashCount; ++i, bits = std::rotr(bits, 9))
+				words[(bits >> 6) & 7] |= std::uint64_t{ 1 } << (bits & 63);
+		}
+
+		bool MayContainHash(std::uint64_t const hash) const noexcept
+		{
+			auto const& words{ _Blocks[BlockIndex(hash)].Words };
+			std::uint64_t bits{ Hashing::Mix64(hash) };
+			for (unsigned i = 0; i < _HashCount; ++i, bits = std::rotr(bits, 9))
+				if ((words[(bits >> 6) & 7] & (std::uint64_t{ 1 } << (bits & 63))) == 0)
+					return false;
+			return true;
+		}
+
+		template<typename T>
+		void Add(T const& value) noexcept
+		{
+			AddHash(Hashing::Hash(value));
+		}
+
+		template<typename T>
+		bool MayContain(T const& value) const noexcept
+		{
+			return MayContainHash(Hashing::Hash(value));
+		}
+
+		std::size_t ByteSize() const noexcept { return _Blocks.size() * sizeof(Block); }
+
+	private:
+		static constexpr std::size_t BlockBits{ 512 };
+
+		struct alignas(64) Block
+		{
+			std::array<std::uint64_t, 8> Words{};
+		};
+
+		//Map the high hash bits onto [0, block count) without a division
+		std::size_t BlockIndex(std::uint64_t const hash) const noexcept
+		{
+			return static_cast<std::size_t>(((hash >> 32) * _Blocks.size()) >> 32);
+		}
+
+		std::vector<Block> _Blocks;
+		unsigned _HashCount;
+	};
+}
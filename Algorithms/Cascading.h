@@ -0,0 +1,179 @@
+#pragma once
+
+#include "pch.h"
+
+//Fractional cascading over k sorted shards: one lower bound query returns the position in every shard
+//(Misc::BinarySearch semantics) with a single binary search plus O(1) work per shard, instead of k binary searches.
+//Level i merges shard i with every second entry of level i + 1. Each entry stores its lower bound in shard i and
+//a bridge to its lower bound in level i + 1; the answer for x in level i + 1 is at most one entry before the bridge.
+//The levels hold at most twice as many entries as the shards together.
+
+namespace Indexes
+{
+	template<typename T> requires std::totally_ordered<T> and std::default_initializable<T>
+	class FractionalCascade
+	{
+	public:
+		FractionalCascade() = default;
+
+		//Shards must be sorted ascending
+		explicit FractionalCascade(std::span<std::span<T const> const> const shards)
+			: _Levels(shards.size()), _ShardSizes(shards.size())
+		{
+			for (std::size_t shard = shards.size(); shard-- > 0;)
+				BuildLevel(shard, shards[shard]);
+		}
+
+		std::size_t ShardCount() const noexcept { return _Levels.size(); }
+		std::size_t ShardSize(std::size_t const shard) const { return _ShardSizes.at(shard); }
+
+		//Entries over all levels (including one sentinel per level)
+		std::size_t EntryCount() const noexcept
+		{
+			return std::transform_reduce(_Levels.begin(), _Levels.end(), std::size_t{ 0 }, std::plus<>{}, [](Level const& level) { return level.size(); });
+		}
+
+		//Replace the contents of one shard. Levels shard, shard - 1, ..., 0 are rebuilt; the levels after it are untouched,
+		//so shards that change often are best placed first.
+		void Rebuild(std::size_t const shard, std::span<T const> const values)
+		{
+			if (shard >= _Levels.size())
+				throw std::out_of_range{ "FractionalCascade: no such shard" };
+			BuildLevel(shard, values);
+			for (std::size_t level = shard; level-- > 0;)
+			{
+				std::vector<T> previous;
+				previous.reserve(_ShardSizes[level]);
+				for (std::size_t i = 0; i + 1 < _Levels[level].size(); ++i)
+					if (_Levels[level][i].FromShard)
+						previous.push_back(_Levels[level][i].Key);
+				BuildLevel(level, previous);
+			}
+		}
+
+		//positions[i] = index of the first element >= value in shard i, or the shard's size if there is none
+		void LowerBounds(T const& value, std::span<std::size_t> const positions) const
+		{
+			if (positions.size() != _Levels.size())
+				throw std::length_error{ "FractionalCascade: one position per shard expected" };
+			if (_Levels.empty())
+				return;
+			auto const& first{ _Levels.front() };
+			auto const found{ std::lower_bound(first.begin(), first.end() - 1, value, [](Entry const& entry, T const& key) { return entry.Key < key; }) };
+			std::size_t position{ static_cast<std::size_t>(found - first.begin()) };
+			for (std::size_t shard = 0; shard < _Levels.size(); ++shard)
+			{
+				Entry const& entry{ _Levels[shard][position] };
+				positions[shard] = entry.Own;
+				if (shard + 1 == _Levels.size())
+					break;
+				position = entry.Bridge;
+				auto const& next{ _Levels[shard + 1] };
+				while (position > 0 and not (next[position - 1].Key < value))
+					--position;
+			}
+		}
+
+		//Many queries at once: positions[q * ShardCount() + i] is the lower bound of values[q] in shard i.
+		//A single query is a chain of dependent cache misses, one per level; a group of queries walks the levels together
+		//and prefetches every entry it will read on the next level, so the misses of the group overlap.
+		void LowerBounds(std::span<T const> const values, std::span<std::size_t> const positions) const
+		{
+			std::size_t const shards{ _Levels.size() };
+			if (positions.size() != values.size() * shards)
+				throw std::length_error{ "FractionalCascade: one position per shard and value expected" };
+			if (_Levels.empty())
+				return;
+			constexpr std::size_t GroupSize{ 16 };
+			auto const& first{ _Levels.front() };
+			std::array<std::size_t, GroupSize> current{};
+			for (std::size_t begin = 0; begin < values.size(); begin += GroupSize)
+			{
+				std::size_t const count{ std::min(GroupSize, values.size() - begin) };
+				for (std::size_t q = 0; q < count; ++q)
+				{
+					auto const found{ std::lower_bound(first.begin(), first.end() - 1, values[begin + q], [](Entry const& entry, T const& key) { return entry.Key < key; }) };
+					current[q] = static_cast<std::size_t>(found - first.begin());
+				}
+				for (std::size_t shard = 0; shard < shards; ++shard)
+				{
+					auto const& level{ _Levels[shard] };
+					bool const last{ shard + 1 == shards };
+					for (std::size_t q = 0; q < count; ++q)
+					{
+						Entry const& entry{ level[current[q]] };
+						positions[(begin + q) * shards + shard] = entry.Own;
+						if (last)
+							continue;
+						current[q] = entry.Bridge;
+#if defined(__GNUC__) || defined(__clang__)
+						__builtin_prefetch(_Levels[shard + 1].data() + current[q] - (current[q] > 0));
+#endif
+					}
+					if (last)
+						break;
+					auto const& next{ _Levels[shard + 1] };
+					for (std::size_t q = 0; q < count; ++q)
+						while (current[q] > 0 and not (next[current[q] - 1].Key < values[begin + q]))
+							--current[q];
+				}
+			}
+		}
+
+		std::vector<std::size_t> LowerBounds(T const& value) const
+		{
+			std::vector<std::size_t> positions(_Levels.size());
+			LowerBounds(value, positions);
+			return positions;
+		}
+
+	private:
+		struct Entry
+		{
+			T Key;
+			std::uint32_t Own : 31;		//lower bound of Key in this level's shard
+			std::uint32_t FromShard : 1;	//0 for entries promoted from the next level (packed: 12 bytes per entry for 4 byte keys)
+			std::uint32_t Bridge;		//lower bound of Key in the next level
+		};
+		using Level = std::vector<Entry>;
+
+		//Merge the shard with every second entry of the next level; the last entry is a sentinel standing for "past the end"
+		void BuildLevel(std::size_t const shard, std::span<T const> const values)
+		{
+			static Level const none;
+			Level const& next{ shard + 1 < _Levels.size() ? _Levels[shard + 1] : none };
+			std::size_t const nextCount{ next.empty() ? 0 : next.size() - 1 };
+			if (values.size() + nextCount / 2 >= std::numeric_limits<std::int32_t>::max())
+				throw std::length_error{ "FractionalCascade: shard too large" };
+			assert(std::ranges::is_sorted(values));
+
+			Level level;
+			level.reserve(values.size() + nextCount / 2 + 1);
+			std::size_t own{ 0 };
+			std::size_t bridge{ 0 };
+			auto const append = [&](T const& key, std::uint32_t const fromShard) {
+				while (own < values.size() and values[own] < key)
+					++own;
+				while (bridge < nextCount and next[bridge].Key < key)
+					++bridge;
+				level.push_back({ key, static_cast<std::uint32_t>(own), fromShard, static_cast<std::uint32_t>(bridge) });
+			};
+			std::size_t promoted{ 1 };
+			for (auto const& value : values)
+			{
+				for (; promoted < nextCount and next[promoted].Key < value; promoted += 2)
+					append(next[promoted].Key, 0);
+				append(value, 1);
+			}
+			for (; promoted < nextCount; promoted += 2)
+				append(next[promoted].Key, 0);
+			level.push_back({ T{}, static_cast<std::uint32_t>(values.size()), 0, static_cast<std::uint32_t>(nextCount) });
+
+			_Levels[shard] = std::move(level);
+			_ShardSizes[shard] = values.size();
+		}
+
+		std::vector<Level> _Levels;
+		std::vector<std::size_t> _ShardSizes;
+	};
+}
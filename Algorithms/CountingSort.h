@@ -0,0 +1,140 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "Parallel.h"
+#include "FastAlgorithms.h"
+
+//Counting sort and histogram kernels for integers from a small domain (e.g. 1..100 as in Exercise9)
+
+namespace Counting
+{
+	//Largest value range (max - min + 1) that DomainSort sorts by counting
+	inline constexpr std::size_t MaxCountingRange{ std::size_t{ 1 } << 20 };
+
+	template<std::integral T>
+	struct Bounds
+	{
+		T Min{};
+		T Max{};
+
+		//Number of distinct values in [Min, Max]; the full 64 bit domain (2^64 values) saturates to SIZE_MAX
+		std::size_t Range() const noexcept
+		{
+			using U = std::make_unsigned_t<T>;
+			auto const span{ static_cast<std::size_t>(static_cast<U>(static_cast<U>(Max) - static_cast<U>(Min))) };
+			return span == std::numeric_limits<std::size_t>::max() ? span : span + 1;
+		}
+	};
+
+	//Minimum and maximum in one pass (AVX2 for int32). values must not be empty.
+	template<std::integral T>
+	Bounds<T> MinMax(std::span<T const> const values) noexcept
+	{
+		assert(not values.empty());
+		std::size_t i{ 0 };
+		T low{ values[0] };
+		T high{ values[0] };
+#if defined(__AVX2__)
+		if constexpr (std::same_as<T, std::int32_t> or (std::same_as<T, int> and sizeof(int) == 4))
+		{
+			if (values.size() >= 8)
+			{
+				__m256i lowLanes{ _mm256_set1_epi32(low) };
+				__m256i highLanes{ lowLanes };
+				for (; i + 8 <= values.size(); i += 8)
+				{
+					__m256i const x{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(values.data() + i)) };
+					lowLanes = _mm256_min_epi32(lowLanes, x);
+					highLanes = _mm256_max_epi32(highLanes, x);
+				}
+				alignas(32) std::array<std::int32_t, 8> lows;
+				alignas(32) std::array<std::int32_t, 8> highs;
+				_mm256_store_si256(reinterpret_cast<__m256i*>(lows.data()), lowLanes);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(highs.data()), highLanes);
+				low = *std::ranges::min_element(lows);
+				high = *std::ranges::max_element(highs);
+			}
+		}
+#endif
+		for (; i < values.size(); ++i)
+		{
+			low = std::min(low, values[i]);
+			high = std::max(high, values[i]);
+		}
+		return { low, high };
+	}
+
+	//Count of each value in [min, min + binCount); values outside are ignored
+	template<std::integral T>
+	std::vector<std::size_t> Histogram(std::span<T const> const values, T const min, std::size_t const binCount)
+	{
+		using U = std::make_unsigned_t<T>;
+		std::vector<std::size_t> bins(binCount);
+		for (T const value : values)
+		{
+			auto const bin{ static_cast<std::size_t>(static_cast<U>(static_cast<U>(value) - static_cast<U>(min))) };
+			if (bin < binCount)
+				++bins[bin];
+		}
+		return bins;
+	}
+
+	//Histogram with privatized bins: every thread counts its partition into its own bins, which are summed at the end
+	template<std::integral T>
+	std::vector<std::size_t> ParallelHistogram(std::span<T const> const values, T const min, std::size_t const binCount, unsigned const threads = Parallel::ThreadCount())
+	{
+		unsigned const partitions{ Parallel::PartitionCount(values.size(), threads) };
+		std::vector<std::vector<std::size_t>> privateBins(partitions);
+		Parallel::ForEachPartition(values.size(), [&](unsigned const index, Parallel::Range const range) {
+			privateBins[index] = Histogram(values.subspan(range.Begin, range.End - range.Begin), min, binCount);
+		}, partitions);
+		std::vector<std::size_t> bins{ std::move(privateBins[0]) };
+		for (unsigned i = 1; i < partitions; ++i)
+			std::transform(bins.begin(), bins.end(), privateBins[i].begin(), bins.begin(), std::plus<>{});
+		return bins;
+	}
+
+	//Sort values whose range is known by counting them and writing each value count times
+	template<std::integral T>
+	void CountingSort(std::span<T> const values, Bounds<T> const bounds)
+	{
+		using U = std::make_unsigned_t<T>;
+		auto const bins{ Histogram(std::span<T const>{ values }, bounds.Min, bounds.Range()) };
+		auto out{ values.begin() };
+		for (std::size_t bin = 0; bin < bins.size(); ++bin)
+		{
+			//Min + bin in the unsigned type: incrementing a signed value past Max == INT_MAX would overflow
+			auto const value{ static_cast<T>(static_cast<U>(static_cast<U>(bounds.Min) + static_cast<U>(bin))) };
+			out = std::fill_n(out, bins[bin], value);
+		}
+	}
+
+	//Sort ascending: measures the value range first and uses counting sort if it is small, FastPath::Sort otherwise
+	template<std::random_access_iterator It>
+	void DomainSort(It first, It last)
+	{
+		using T = std::iter_value_t<It>;
+		if constexpr (Traits::ContiguousIterator<It> and std::integral<T> and not std::same_as<T, bool>)
+		{
+			std::span<T> const values{ std::to_address(first), static_cast<std::size_t>(last - first) };
+			if (values.size() > 1)
+			{
+				auto const bounds{ MinMax(std::span<T const>{ values }) };
+				//Counting pays off when there are not many more bins than elements
+				if (bounds.Range() <= MaxCountingRange and bounds.Range() <= 2 * values.size())
+				{
+					CountingSort(values, bounds);
+					return;
+				}
+			}
+		}
+		FastPath::Sort(first, last);
+	}
+
+	template<std::ranges::random_access_range R>
+	void DomainSort(R&& range)
+	{
+		DomainSort(std::ranges::begin(range), std::ranges::end(range));
+	}
+}
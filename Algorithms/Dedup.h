@@ -0,0 +1,204 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "Parallel.h"
+#include "FastAlgorithms.h"
+
+//Deduplication of large ID vectors: SIMD compaction for sorted input,
+//parallel hash-partitioned dedup for unsorted input (optionally keeping the first occurrence order)
+
+namespace Dedup
+{
+	namespace Detail
+	{
+#if defined(__AVX2__)
+		//For each 8 bit keep mask: the lane indices of the kept lanes, packed to the front
+		inline constexpr auto CompactionTable = [] {
+			std::array<std::array<std::int32_t, 8>, 256> table{};
+			for (unsigned mask = 0; mask < 256; ++mask)
+			{
+				unsigned out{ 0 };
+				for (unsigned lane = 0; lane < 8; ++lane)
+					if (mask & (1u << lane))
+						table[mask][out++] = static_cast<std::int32_t>(lane);
+			}
+			return table;
+		}();
+#endif
+
+		//Fibonacci hashing spreads consecutive IDs evenly
+		template<typename T>
+		std::uint64_t Hash(T const& value) noexcept
+		{
+			std::uint64_t hash;
+			if constexpr (std::integral<T>)
+				hash = static_cast<std::uint64_t>(value);
+			else
+				hash = std::hash<T>{}(value);
+			hash *= 0x9E3779B97F4A7C15ull;
+			return hash ^ (hash >> 29);
+		}
+
+		//Bucket of a value; uses the high hash bits so the bucket and the slot in a bucket's hash set are independent
+		template<typename T>
+		std::size_t Bucket(T const& value, unsigned const bucketCount) noexcept
+		{
+			return static_cast<std::size_t>((Hash(value) >> 40) % bucketCount);
+		}
+	}
+
+	//Remove consecutive duplicates from a sorted span and return the new size (same as std::unique).
+	//int32 values are compared with their left neighbour 8 at a time and the kept lanes are compacted with a permutation.
+	template<typename T>
+	std::size_t UniqueSorted(std::span<T> const values)
+	{
+		if (values.size() < 2)
+			return values.size();
+#if defined(__AVX2__)
+		if constexpr (std::integral<T> and sizeof(T) == 4)
+		{
+			T* data{ values.data() };
+			std::size_t out{ 1 }; //the first element is always kept
+			std::size_t i{ 1 };
+			__m256i previousLast{ _mm256_set1_epi32(static_cast<int>(data[0])) };
+			__m256i const shiftByOne{ _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6) };
+			for (; i + 8 <= values.size(); i += 8)
+			{
+				//Only registers are compared: the compacted stores may already have overwritten data[i - 1]
+				__m256i const x{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)) };
+				__m256i const neighbours{ _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shiftByOne), previousLast, 0x01) };
+				unsigned const duplicates{ static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, neighbours)))) };
+				unsigned const keep{ ~duplicates & 0xFF };
+				__m256i const permutation{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(Detail::CompactionTable[keep].data())) };
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + out), _mm256_permutevar8x32_epi32(x, permutation));
+				out += std::popcount(keep);
+				previousLast = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+			}
+			T last{ static_cast<T>(_mm256_cvtsi256_si32(previousLast)) };
+			for (; i < values.size(); ++i)
+			{
+				T const value{ data[i] };
+				if (value != last)
+					data[out++] = value;
+				last = value;
+			}
+			return out;
+		}
+#endif
+		return static_cast<std::size_t>(std::unique(values.begin(), values.end()) - values.begin());
+	}
+
+	//The classic sort + unique + erase, with the fast paths
+	template<typename T>
+	void SortAndDedup(std::vector<T>& v)
+	{
+		FastPath::Sort(v);
+		v.resize(UniqueSorted(std::span<T>{ v }));
+	}
+
+	//Dedup unsorted values in parallel. The values are scattered into one hash bucket per thread, so equal values
+	//meet in the same bucket, and each bucket is deduplicated on its own.
+	//keepFirstOrder: the result keeps the first occurrence of each value in input order, otherwise the order is unspecified.
+	template<std::totally_ordered T>
+	void ParallelDedup(std::vector<T>& v, bool const keepFirstOrder = false, unsigned const threads = Parallel::ThreadCount())
+	{
+		std::size_t const count{ v.size() };
+		unsigned const partitions{ Parallel::PartitionCount(count, threads) };
+		unsigned const bucketCount{ partitions };
+
+		//Pass 1: every partition counts its elements per bucket, in local counters so that the threads do not share cache lines
+		std::vector<std::size_t> offsets(static_cast<std::size_t>(partitions) * bucketCount);
+		Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+			std::vector<std::size_t> counts(bucketCount);
+			for (std::size_t i = range.Begin; i < range.End; ++i)
+				++counts[Detail::Bucket(v[i], bucketCount)];
+			for (unsigned bucket = 0; bucket < bucketCount; ++bucket)
+				offsets[bucket * partitions + index] = counts[bucket];
+		}, partitions);
+		//Bucket-major exclusive scan: bucket b gets one contiguous region, filled in partition order
+		std::vector<std::size_t> bucketBegin(bucketCount + 1);
+		std::size_t sum{ 0 };
+		for (unsigned bucket = 0; bucket < bucketCount; ++bucket)
+		{
+			bucketBegin[bucket] = sum;
+			for (unsigned partition = 0; partition < partitions; ++partition)
+				sum += std::exchange(offsets[bucket * partitions + partition], sum);
+		}
+		bucketBegin[bucketCount] = sum;
+
+		//Pass 2: scatter the values (and for keepFirstOrder their original indices) to their buckets.
+		//Within a bucket the values stay in input order.
+		std::vector<T> values(count);
+		std::vector<std::size_t> indices(keepFirstOrder ? count : 0);
+		Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+			std::vector<std::size_t> next(bucketCount);
+			for (unsigned bucket = 0; bucket < bucketCount; ++bucket)
+				next[bucket] = offsets[bucket * partitions + index];
+			for (std::size_t i = range.Begin; i < range.End; ++i)
+			{
+				std::size_t const target{ next[Detail::Bucket(v[i], bucketCount)]++ };
+				values[target] = v[i];
+				if (keepFirstOrder)
+					indices[target] = i;
+			}
+		}, partitions);
+
+		//Pass 3: dedup each bucket: with a hash set to keep the input order, otherwise with sort + unique
+		std::vector<std::uint8_t> keep(keepFirstOrder ? count : 0);
+		std::vector<std::size_t> uniqueCounts(bucketCount);
+		Parallel::ForEachPartition(bucketCount, [&](unsigned, Parallel::Range const range) {
+			for (std::size_t bucket = range.Begin; bucket < range.End; ++bucket)
+			{
+				std::size_t const begin{ bucketBegin[bucket] };
+				std::size_t const end{ bucketBegin[bucket + 1] };
+				if (keepFirstOrder)
+				{
+					//Walk the bucket in input order and keep every value that is new to the bucket's hash set
+					std::size_t const capacity{ std::bit_ceil(2 * (end - begin) + 1) };
+					std::vector<T> slots(capacity);
+					std::vector<std::uint8_t> used(capacity);
+					for (std::size_t i = begin; i < end; ++i)
+					{
+						std::size_t slot{ Detail::Hash(values[i]) & (capacity - 1) };
+						while (used[slot] and not (slots[slot] == values[i]))
+							slot = (slot + 1) & (capacity - 1);
+						if (not used[slot])
+						{
+							used[slot] = 1;
+							slots[slot] = values[i];
+							keep[indices[i]] = 1;
+						}
+					}
+				}
+				else
+				{
+					FastPath::Sort(values.begin() + begin, values.begin() + end);
+					uniqueCounts[bucket] = UniqueSorted(std::span<T>{ values.data() + begin, end - begin });
+				}
+			}
+		}, partitions);
+
+		if (keepFirstOrder)
+		{
+			std::size_t out{ 0 };
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (not keep[i])
+					continue;
+				if (out != i)
+					v[out] = std::move(v[i]);
+				++out;
+			}
+			v.resize(out);
+		}
+		else
+		{
+			std::size_t out{ 0 };
+			for (unsigned bucket = 0; bucket < bucketCount; ++bucket)
+				for (std::size_t i = 0; i < uniqueCounts[bucket]; ++i)
+					v[out++] = std::move(values[bucketBegin[bucket] + i]);
+			v.resize(out);
+		}
+	}
+}
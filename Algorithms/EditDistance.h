@@ -0,0 +1,328 @@
+#pragma once
+
+#include "pch.h"
+#include "SmallVector.h"
+
+//Approximate string matching with Myers' bit-parallel edit distance: one column of the dynamic program is
+//kept as bit vectors of vertical +1/-1 deltas, so a pattern of up to 64 bytes costs about 15 word operations
+//per text byte instead of a loop over the column. Longer patterns use blocks of 64 rows (Hyyro's extension).
+//The distances are Levenshtein distances over bytes.
+
+namespace Similarity
+{
+	inline constexpr std::size_t Unlimited{ std::numeric_limits<std::size_t>::max() };
+
+	//Textbook dynamic program with one row, O(|a| * |b|); the reference for the fast versions
+	inline std::size_t Levenshtein(std::string_view const a, std::string_view const b)
+	{
+		std::vector<std::size_t> row(b.size() + 1);
+		std::iota(row.begin(), row.end(), std::size_t{ 0 });
+		for (std::size_t i = 1; i <= a.size(); ++i)
+		{
+			std::size_t diagonal{ row[0] };
+			row[0] = i;
+			for (std::size_t j = 1; j <= b.size(); ++j)
+			{
+				std::size_t const substitution{ diagonal + (a[i - 1] != b[j - 1]) };
+				diagonal = row[j];
+				row[j] = std::min({ substitution, row[j] + 1, row[j - 1] + 1 });
+			}
+		}
+		return row[b.size()];
+	}
+
+	class MyersPattern
+	{
+	public:
+		explicit MyersPattern(std::string_view const pattern)
+			: _Size{ pattern.size() }, _Words{ std::max<std::size_t>(1, (pattern.size() + 63) / 64) }, _Peq(256 * _Words)
+		{
+			//Peq[c] has bit i set where pattern[i] == c
+			for (std::size_t i = 0; i < pattern.size(); ++i)
+				_Peq[static_cast<std::uint8_t>(pattern[i]) * _Words + i / 64] |= std::uint64_t{ 1 } << (i % 64);
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+
+		//Edit distance to text, or maxDistance + 1 as soon as the distance is known to exceed maxDistance
+		std::size_t Distance(std::string_view const text, std::size_t const maxDistance = Unlimited) const
+		{
+			std::size_t const cap{ maxDistance == Unlimited ? Unlimited : maxDistance + 1 };
+			std::size_t const lengthDifference{ _Size > text.size() ? _Size - text.size() : text.size() - _Size };
+			if (lengthDifference > maxDistance)
+				return cap;
+			if (_Size == 0)
+				return text.size();
+			return std::min(_Words == 1 ? DistanceWord(text, maxDistance) : DistanceBlocks(text, maxDistance), cap);
+		}
+
+		//Bit mask of the text byte's positions in word w of the pattern
+		std::uint64_t Peq(std::uint8_t const c, std::size_t const w = 0) const noexcept
+		{
+			return _Peq[c * _Words + w];
+		}
+
+	private:
+		//The distance can drop by at most one per remaining text byte
+		static bool Hopeless(std::size_t const score, std::size_t const remaining, std::size_t const maxDistance) noexcept
+		{
+			return score > remaining and score - remaining > maxDistance;
+		}
+
+		std::size_t DistanceWord(std::string_view const text, std::size_t const maxDistance) const noexcept
+		{
+			std::uint64_t pv{ ~std::uint64_t{ 0 } };
+			std::uint64_t mv{ 0 };
+			std::uint64_t const last{ std::uint64_t{ 1 } << (_Size - 1) };
+			std::size_t score{ _Size };
+			for (std::size_t j = 0; j < text.size(); ++j)
+			{
+				std::uint64_t const eq{ _Peq[static_cast<std::uint8_t>(text[j])] };
+				std::uint64_t const xv{ eq | mv };
+				std::uint64_t const xh{ (((eq & pv) + pv) ^ pv) | eq };
+				std::uint64_t ph{ mv | ~(xh | pv) };
+				std::uint64_t mh{ pv & xh };
+				score += (ph & last) != 0;
+				score -= (mh & last) != 0;
+				ph = (ph << 1) | 1; //the first row grows by one per column
+				mh <<= 1;
+				pv = mh | ~(xv | ph);
+				mv = ph & xv;
+				if (Hopeless(score, text.size() - j - 1, maxDistance))
+					return maxDistance + 1;
+			}
+			return score;
+		}
+
+		//64 rows per block; the horizontal delta of a block's last row is carried into the next block
+		std::size_t DistanceBlocks(std::string_view const text, std::size_t const maxDistance) const
+		{
+			Containers::SmallVector<std::uint64_t, 4> pv(_Words, ~std::uint64_t{ 0 });
+			Containers::SmallVector<std::uint64_t, 4> mv(_Words, 0);
+			std::uint64_t const last{ std::uint64_t{ 1 } << ((_Size - 1) % 64) };
+			std::size_t score{ _Size };
+			for (std::size_t j = 0; j < text.size(); ++j)
+			{
+				std::uint64_t const* const peq{ _Peq.data() + static_cast<std::uint8_t>(text[j]) * _Words };
+				int carry{ 1 };
+				for (std::size_t w = 0; w < _Words; ++w)
+				{
+					std::uint64_t eq{ peq[w] };
+					std::uint64_t const xv{ eq | mv[w] };
+					if (carry < 0)
+						eq |= 1;
+					std::uint64_t const xh{ (((eq & pv[w]) + pv[w]) ^ pv[w]) | eq };
+					std::uint64_t ph{ mv[w] | ~(xh | pv[w]) };
+					std::uint64_t mh{ pv[w] & xh };
+					std::uint64_t const high{ w + 1 == _Words ? last : std::uint64_t{ 1 } << 63 };
+					int const out{ (ph & high) != 0 ? 1 : ((mh & high) != 0 ? -1 : 0) };
+					ph <<= 1;
+					mh <<= 1;
+					if (carry < 0)
+						mh |= 1;
+					else if (carry > 0)
+						ph |= 1;
+					pv[w] = mh | ~(xv | ph);
+					mv[w] = ph & xv;
+					carry = out;
+				}
+				score += static_cast<std::size_t>(carry); //carry is the delta of the last row, -1 wraps around as intended
+				if (Hopeless(score, text.size() - j - 1, maxDistance))
+					return maxDistance + 1;
+			}
+			return score;
+		}
+
+		std::size_t _Size;
+		std::size_t _Words;
+		std::vector<std::uint64_t> _Peq;
+	};
+
+	//Distances of one pattern to many texts, each capped at maxDistance + 1. Texts whose length differs by more than
+	//maxDistance are not compared. With AVX2 and a pattern of up to 64 bytes, four texts run in the four 64 bit lanes.
+	inline std::vector<std::uint32_t> BatchDistance(MyersPattern const& pattern, std::span<std::string const> const texts, std::size_t const maxDistance)
+	{
+		auto const cap{ static_cast<std::uint32_t>(std::min<std::size_t>(maxDistance, std::numeric_limits<std::uint32_t>::max() - 1) + 1) };
+		std::vector<std::uint32_t> distances(texts.size(), cap);
+		std::size_t const m{ pattern.Size() };
+		std::vector<std::uint32_t> candidates;
+		for (std::size_t i = 0; i < texts.size(); ++i)
+			if ((m > texts[i].size() ? m - texts[i].size() : texts[i].size() - m) <= maxDistance)
+				candidates.push_back(static_cast<std::uint32_t>(i));
+
+		std::size_t c{ 0 };
+#if defined(__AVX2__)
+		if (m >= 1 and m <= 64)
+		{
+			__m256i const ones{ _mm256_set1_epi64x(-1) };
+			__m256i const one{ _mm256_set1_epi64x(1) };
+			__m256i const last{ _mm256_set1_epi64x(static_cast<long long>(std::uint64_t{ 1 } << (m - 1))) };
+			for (; c + 4 <= candidates.size(); c += 4)
+			{
+				std::array<std::string_view, 4> lane;
+				std::array<long long, 4> lengths;
+				std::size_t longest{ 0 };
+				for (std::size_t l = 0; l < 4; ++l)
+				{
+					lane[l] = texts[candidates[c + l]];
+					lengths[l] = static_cast<long long>(lane[l].size());
+					longest = std::max(longest, lane[l].size());
+				}
+				__m256i const length{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lengths.data())) };
+				__m256i pv{ ones };
+				__m256i mv{ _mm256_setzero_si256() };
+				__m256i score{ _mm256_set1_epi64x(static_cast<long long>(m)) };
+				for (std::size_t j = 0; j < longest; ++j)
+				{
+					auto const peq = [&](std::size_t const l) { return static_cast<long long>(j < lane[l].size() ? pattern.Peq(static_cast<std::uint8_t>(lane[l][j])) : 0); };
+					__m256i const eq{ _mm256_setr_epi64x(peq(0), peq(1), peq(2), peq(3)) };
+					__m256i const active{ _mm256_cmpgt_epi64(length, _mm256_set1_epi64x(static_cast<long long>(j))) };
+					__m256i const xv{ _mm256_or_si256(eq, mv) };
+					__m256i const sum{ _mm256_add_epi64(_mm256_and_si256(eq, pv), pv) };
+					__m256i const xh{ _mm256_or_si256(_mm256_xor_si256(sum, pv), eq) };
+					__m256i ph{ _mm256_or_si256(mv, _mm256_xor_si256(_mm256_or_si256(xh, pv), ones)) };
+					__m256i mh{ _mm256_and_si256(pv, xh) };
+					//-1 in lanes where the last row changes; +1 for ph, -1 for mh
+					__m256i const up{ _mm256_cmpeq_epi64(_mm256_and_si256(ph, last), last) };
+					__m256i const down{ _mm256_cmpeq_epi64(_mm256_and_si256(mh, last), last) };
+					score = _mm256_add_epi64(score, _mm256_and_si256(active, _mm256_sub_epi64(down, up)));
+					ph = _mm256_or_si256(_mm256_slli_epi64(ph, 1), one);
+					mh = _mm256_slli_epi64(mh, 1);
+					pv = _mm256_blendv_epi8(pv, _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), ones)), active);
+					mv = _mm256_blendv_epi8(mv, _mm256_and_si256(ph, xv), active);
+					//Early exit once every lane exceeds maxDistance even if all its remaining bytes matched
+					if (j % 4 == 3)
+					{
+						__m256i const remaining{ _mm256_sub_epi64(length, _mm256_set1_epi64x(static_cast<long long>(j + 1))) };
+						__m256i const hopeless{ _mm256_cmpgt_epi64(_mm256_sub_epi64(score, remaining), _mm256_set1_epi64x(static_cast<long long>(cap - 1))) };
+						if (_mm256_movemask_pd(_mm256_castsi256_pd(hopeless)) == 0xF)
+							break;
+					}
+				}
+				std::array<long long, 4> scores;
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(scores.data()), score);
+				for (std::size_t l = 0; l < 4; ++l)
+					distances[candidates[c + l]] = static_cast<std::uint32_t>(std::min<std::size_t>(static_cast<std::size_t>(scores[l]), cap));
+			}
+		}
+#endif
+		for (; c < candidates.size(); ++c)
+			distances[candidates[c]] = static_cast<std::uint32_t>(std::min<std::size_t>(pattern.Distance(texts[candidates[c]], maxDistance), cap));
+		return distances;
+	}
+
+	//Names ordered by length: only the names whose length is within maxDistance of the query are compared
+	class LengthIndex
+	{
+	public:
+		explicit LengthIndex(std::span<std::string const> const names)
+		{
+			std::vector<std::uint32_t> order(names.size());
+			std::iota(order.begin(), order.end(), 0u);
+			std::ranges::stable_sort(order, {}, [&](std::uint32_t const i) { return names[i].size(); });
+			_Names.reserve(names.size());
+			for (auto const i : order)
+				_Names.push_back(names[i]);
+			_Ids = std::move(order);
+		}
+
+		//Ids of the names within maxDistance of query
+		std::vector<std::uint32_t> Within(std::string_view const query, std::size_t const maxDistance) const
+		{
+			auto const byLength = [](std::string const& name) { return name.size(); };
+			std::size_t const shortest{ query.size() > maxDistance ? query.size() - maxDistance : 0 };
+			auto const first{ std::ranges::lower_bound(_Names, shortest, {}, byLength) };
+			auto const last{ std::ranges::upper_bound(_Names, query.size() + maxDistance, {}, byLength) };
+			std::span<std::string const> const window{ first, last };
+			auto const distances{ BatchDistance(MyersPattern{ query }, window, maxDistance) };
+			std::vector<std::uint32_t> result;
+			for (std::size_t i = 0; i < window.size(); ++i)
+				if (distances[i] <= maxDistance)
+					result.push_back(_Ids[static_cast<std::size_t>(first - _Names.begin()) + i]);
+			std::ranges::sort(result);
+			return result;
+		}
+
+	private:
+		std::vector<std::string> _Names;
+		std::vector<std::uint32_t> _Ids;
+	};
+
+	//Burkhard-Keller tree: children are keyed by their distance to the parent, and the triangle inequality
+	//limits a query with distance d to the parent to the children keyed d - maxDistance ... d + maxDistance.
+	//The tree refers to the names, which must outlive it.
+	class BkTree
+	{
+	public:
+		explicit BkTree(std::span<std::string const> const names)
+			: _Names{ names }
+		{
+			for (std::uint32_t id = 0; id < names.size(); ++id)
+				Insert(id);
+		}
+
+		//Ids of the names within maxDistance of query
+		std::vector<std::uint32_t> Within(std::string_view const query, std::size_t const maxDistance) const
+		{
+			std::vector<std::uint32_t> result;
+			if (_Nodes.empty())
+				return result;
+			MyersPattern const pattern{ query };
+			std::vector<std::uint32_t> stack{ 0 };
+			while (not stack.empty())
+			{
+				Node const& node{ _Nodes[stack.back()] };
+				stack.pop_back();
+				std::size_t const distance{ pattern.Distance(_Names[node.Ids.front()]) };
+				if (distance <= maxDistance)
+					result.insert(result.end(), node.Ids.begin(), node.Ids.end());
+				for (auto const& [childDistance, child] : node.Children)
+					if (childDistance + maxDistance >= distance and childDistance <= distance + maxDistance)
+						stack.push_back(child);
+			}
+			std::ranges::sort(result);
+			return result;
+		}
+
+		std::size_t Size() const noexcept { return _Nodes.size(); }
+
+	private:
+		struct Node
+		{
+			Containers::SmallVector<std::uint32_t, 1> Ids; //equal names share a node
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> Children; //(distance to this node, child node)
+		};
+
+		void Insert(std::uint32_t const id)
+		{
+			if (_Nodes.empty())
+			{
+				_Nodes.push_back({ { id }, {} });
+				return;
+			}
+			MyersPattern const pattern{ _Names[id] };
+			std::uint32_t current{ 0 };
+			while (true)
+			{
+				auto const distance{ static_cast<std::uint32_t>(pattern.Distance(_Names[_Nodes[current].Ids.front()])) };
+				if (distance == 0)
+				{
+					_Nodes[current].Ids.push_back(id);
+					return;
+				}
+				auto& children{ _Nodes[current].Children };
+				auto const child{ std::ranges::find(children, distance, &std::pair<std::uint32_t, std::uint32_t>::first) };
+				if (child == children.end())
+				{
+					children.emplace_back(distance, static_cast<std::uint32_t>(_Nodes.size()));
+					_Nodes.push_back({ { id }, {} });
+					return;
+				}
+				current = child->second;
+			}
+		}
+
+		std::span<std::string const> _Names;
+		std::vector<Node> _Nodes;
+	};
+}
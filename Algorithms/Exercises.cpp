@@ -6,6 +6,32 @@ Pleasae try to use STL algorythms and other STL features to solve the below exer
 */
 
 #include "pch.h" //used for precompiled headers
+#include "FastAlgorithms.h"
+#include "Numa.h"
+#include "HugePages.h"
+#include "SmallVector.h"
+#include "SelectionList.h"
+#include "Scan.h"
+#include "CountingSort.h"
+#include "Dedup.h"
+#include "Sketches.h"
+#include "QuantileSketch.h"
+#include "ExternalSort.h"
+#include "ExternalSetOps.h"
+#include "SearchIndex.h"
+#include "LsmStore.h"
+#include "SwissMap.h"
+#include "RadixTree.h"
+#include "TrigramIndex.h"
+#include "EditDistance.h"
+#include "SortByKey.h"
+#include "Permutation.h"
+#include "Cascading.h"
+#include "RangeQuery.h"
+#include "RangeSums.h"
+#include "RankSelect.h"
+#include "Partition.h"
+#include "Benchmark.h"
 
 #pragma region HelperStuff
 
@@ -29,6 +55,9 @@ public:
 	Product() noexcept = default;
 	Product(const Product& other) noexcept
 		: _Name{ other._Name }, _Price{ other._Price }, _FreeDelivery{ other._FreeDelivery } {}
+	Product(Product&& other) noexcept = default;
+	Product& operator=(Product const& other) = default;
+	Product& operator=(Product&& other) noexcept = default;
 	Product(std::string const name, double const price, bool const freeDelivery) noexcept
 		: _Name{ name }, _Price{ price }, _FreeDelivery{ freeDelivery } {}
 
@@ -71,6 +100,43 @@ std::ostream& operator<<(std::ostream& os, const Product& product)
 	return os;
 }
 
+//Binary encoding of a product in external sort run files: price, free delivery flag, length-prefixed name
+template<>
+struct External::RecordTraits<Product>
+{
+	static void Write(std::FILE* file, Product const& product)
+	{
+		double const price{ product.Price() };
+		bool const freeDelivery{ product.FreeDelivery() };
+		std::fwrite(&price, sizeof(price), 1, file);
+		std::fwrite(&freeDelivery, sizeof(freeDelivery), 1, file);
+		External::WriteString(file, product.Name());
+	}
+	static bool Read(std::FILE* file, Product& product)
+	{
+		double price{ 0 };
+		bool freeDelivery{ false };
+		std::string name;
+		if (std::fread(&price, sizeof(price), 1, file) != 1 or std::fread(&freeDelivery, sizeof(freeDelivery), 1, file) != 1 or not External::ReadString(file, name))
+			return false;
+		product = Product{ name, price, freeDelivery };
+		return true;
+	}
+	static std::size_t Size(Product const& product)
+	{
+		return sizeof(Product) + product.Name().size();
+	}
+};
+
+//Owning handle for the relocation benchmark: not trivially copyable, but a memcpy moves it (the unique_ptr is just a pointer)
+struct PriceHandle
+{
+	std::unique_ptr<double> Price;
+};
+
+template<>
+struct Traits::IsTriviallyRelocatable<PriceHandle> : std::true_type {};
+
 //Concept for numerics
 template <typename T>
 concept IsNumeric = std::integral<T> or std::floating_point<T>;
@@ -678,8 +744,1317 @@ namespace Misc {
 	}
 }
 
-int main()
+namespace Benchmarks
+{
+	//Compares each FastPath specialization against the generic STL algorithm
+	void FastPaths()
+	{
+		ExerciseStart t{ "Benchmarks:FastPaths" };
+		std::size_t const count{ 1 << 24 };
+		auto const source{ Bench::RandomVector<int>(count, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) };
+		std::vector<int> v;
+
+		//Copy with back_inserter (Exercise1) vs Append (memcpy)
+		auto const copyStl{ Bench::Measure([&] { v.clear(); v.shrink_to_fit(); }, [&] { std::copy(source.begin(), source.end(), std::back_inserter(v)); }) };
+		auto const copyFast{ Bench::Measure([&] { v.clear(); v.shrink_to_fit(); }, [&] { FastPath::Append(v, source); }) };
+		Bench::Report("copy (std::copy + back_inserter)", copyStl, count * sizeof(int));
+		Bench::Report("copy (FastPath::Append)", copyFast, count * sizeof(int));
+		Bench::ReportSpeedup("copy speedup", copyStl, copyFast);
+
+		//Move of a trivially copyable type: memmove instead of element-wise move assignment
+		//(libstdc++ already lowers std::move on pointers to trivially copyable types to memmove, so expect about 1x there)
+		std::vector<int> moved(count);
+		auto const moveStl{ Bench::Measure([&] { std::move(source.begin(), source.end(), moved.begin()); }) };
+		auto const moveFast{ Bench::Measure([&] { FastPath::Move(source.begin(), source.end(), moved.begin()); }) };
+		Bench::Report("move (std::move)", moveStl, count * sizeof(int));
+		Bench::Report("move (FastPath::Move)", moveFast, count * sizeof(int));
+		Bench::ReportSpeedup("move speedup", moveStl, moveFast);
+
+		//Relocation of a trivially relocatable type (grow a buffer): memmove instead of move-construct + destroy per element
+		{
+			std::size_t const handles{ count / 4 };
+			std::allocator<PriceHandle> allocator;
+			PriceHandle* from{ allocator.allocate(handles) };
+			PriceHandle* to{ allocator.allocate(handles) };
+			std::uninitialized_value_construct_n(from, handles);
+			for (std::size_t i = 0; i < handles; i += 64)
+				from[i].Price = std::make_unique<double>(static_cast<double>(i));
+			//Every run moves the handles from one buffer into the other
+			auto const relocateStl{ Bench::Measure([&] {
+				std::uninitialized_move(from, from + handles, to);
+				std::destroy(from, from + handles);
+				std::swap(from, to);
+			}) };
+			auto const relocateFast{ Bench::Measure([&] {
+				FastPath::Relocate(from, from + handles, to);
+				std::swap(from, to);
+			}) };
+			std::destroy(from, from + handles);
+			allocator.deallocate(from, handles);
+			allocator.deallocate(to, handles);
+			Bench::Report("relocate (uninitialized_move + destroy)", relocateStl, handles * sizeof(PriceHandle));
+			Bench::Report("relocate (FastPath::Relocate)", relocateFast, handles * sizeof(PriceHandle));
+			Bench::ReportSpeedup("relocate speedup", relocateStl, relocateFast);
+		}
+
+		//Reverse (Exercise10)
+		v = source;
+		auto const reverseStl{ Bench::Measure([&] { std::reverse(v.begin(), v.end()); }) };
+		auto const reverseFast{ Bench::Measure([&] { FastPath::Reverse(v); }) };
+		Bench::Report("reverse (std::reverse)", reverseStl, count * sizeof(int));
+		Bench::Report("reverse (FastPath::Reverse)", reverseFast, count * sizeof(int));
+		Bench::ReportSpeedup("reverse speedup", reverseStl, reverseFast);
+
+		//Sort
+		auto const sortStl{ Bench::Measure([&] { v = source; }, [&] { std::sort(v.begin(), v.end()); }) };
+		auto const sortFast{ Bench::Measure([&] { v = source; }, [&] { FastPath::Sort(v); }) };
+		Bench::Check(std::ranges::is_sorted(v), "FastPath::Sort output is sorted");
+		Bench::Report("sort (std::sort)", sortStl, count * sizeof(int));
+		Bench::Report("sort (FastPath::Sort, radix)", sortFast, count * sizeof(int));
+		Bench::ReportSpeedup("sort speedup", sortStl, sortFast);
+
+		//Search (Misc::BinarySearch semantics)
+		auto const queries{ Bench::RandomVector<int>(1 << 20, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), 7) };
+		std::size_t found{ 0 };
+		auto const searchStl{ Bench::Measure([&] {
+			for (int const q : queries)
+				found += std::lower_bound(v.begin(), v.end(), q) != v.end();
+		}) };
+		auto const searchFast{ Bench::Measure([&] {
+			for (int const q : queries)
+				found += FastPath::LowerBound(v.begin(), v.end(), q) != v.end();
+		}) };
+		Bench::DoNotOptimize(found);
+		Bench::Report("search (std::lower_bound)", searchStl);
+		Bench::Report("search (FastPath::LowerBound, branch-free)", searchFast);
+		Bench::ReportSpeedup("search speedup", searchStl, searchFast);
+	}
+
+	//Exercise9's iota fill at scale: serial std::vector vs. NUMA placement with parallel first touch
+	void NumaFirstTouch()
+	{
+		ExerciseStart t{ "Benchmarks:NumaFirstTouch" };
+		std::size_t const count{ 1 << 26 };
+		PrintF("NUMA nodes: {}, threads: {}\n", Memory::NumaNodeCount(), Parallel::ThreadCount());
+
+		//Parallel kernel: sum over the same partitions that were used for the first touch
+		auto const parallelSum = [](auto const& v) {
+			std::vector<std::int64_t> sums(Parallel::ThreadCount());
+			Parallel::ForEachPartition(v.size(), [&](unsigned const index, Parallel::Range const range) {
+				sums[index] = std::accumulate(v.begin() + range.Begin, v.begin() + range.End, std::int64_t{ 0 });
+			});
+			return std::accumulate(sums.begin(), sums.end(), std::int64_t{ 0 });
+		};
+
+		auto const run = [&](std::string_view const name, auto&& make) {
+			std::int64_t sum{ 0 };
+			auto const buildTime{ Bench::Measure([&] { auto v{ make() }; Bench::DoNotOptimize(v.data()); }, 3) };
+			auto const v{ make() };
+			auto const sumTime{ Bench::Measure([&] { sum = parallelSum(v); }) };
+			Bench::DoNotOptimize(sum);
+			Bench::Report(std::format("{} build", name), buildTime, count * sizeof(int));
+			Bench::Report(std::format("{} parallel sum", name), sumTime, count * sizeof(int));
+		};
+
+		run("std::vector + iota", [&] { std::vector<int> v(count); std::iota(v.begin(), v.end(), 10); return v; });
+		run("NUMA interleaved", [&] { return Memory::MakeNumaIota(count, 10, Memory::NumaPlacement::Interleaved); });
+		run("NUMA partitioned", [&] { return Memory::MakeNumaIota(count, 10, Memory::NumaPlacement::Partitioned); });
+	}
+
+	//TLB misses and run time of sort and Misc::BinarySearch with 4K pages vs. huge pages
+	void HugePages()
+	{
+		ExerciseStart t{ "Benchmarks:HugePages" };
+		std::size_t const count{ 1 << 25 };
+		auto const source{ Bench::RandomVector<int>(count, 0, std::numeric_limits<int>::max()) };
+		auto const queries{ Bench::RandomVector<int>(1 << 20, 0, std::numeric_limits<int>::max(), 7) };
+
+		auto const run = [&](std::string_view const name, auto& v) {
+			auto const refill = [&] { std::copy(source.begin(), source.end(), v.begin()); };
+			auto const sort = [&] { FastPath::Sort(v); };
+			std::size_t found{ 0 };
+			auto const search = [&] {
+				for (int const q : queries)
+					found += Misc::BinarySearch(v.begin(), v.end(), q) != v.end();
+			};
+
+			Bench::Report(std::format("{} sort", name), Bench::Measure(refill, sort, 3), count * sizeof(int));
+			Bench::ReportCount(std::format("{} sort dTLB misses", name), Bench::Count(Bench::PerfEvent::DtlbLoadMisses, refill, sort));
+			Bench::Report(std::format("{} BinarySearch", name), Bench::Measure(search, 3));
+			Bench::ReportCount(std::format("{} BinarySearch dTLB misses", name), Bench::Count(Bench::PerfEvent::DtlbLoadMisses, [] {}, search));
+			Bench::DoNotOptimize(found);
+		};
+
+		std::vector<int> small(count);
+		run("4K pages", small);
+		Memory::HugePageVector<int> huge(count);
+		run("huge pages", huge);
+	}
+
+	//The vector operations of ContainerAlgorithm::Exercise1-16, for any vector type with the std::vector interface
+	template<typename IntVector, typename StringVector>
+	int ExercisePatterns()
+	{
+		IntVector v1{ 1,2,3,4,5,6,7,8 };
+		IntVector v2{ 10,11,12,13,14,15,16,17,18,19 };
+		v2.insert(v2.end(), v1.begin(), v1.end());															//Exercise 1
+		std::copy_if(v1.begin(), v1.end(), std::back_inserter(v2), [](int x) { return x > 5; });			//Exercise 2
+		std::reverse_copy(v1.begin(), v1.end(), std::back_inserter(v2));									//Exercise 4
+		std::transform(v1.begin(), v1.end(), v1.begin(), [](int x) { return x + 1; });						//Exercise 6
+		IntVector v3;
+		std::copy_if(v1.begin(), v1.end(), std::back_inserter(v3), [&v2](int x) { return std::find(v2.begin(), v2.end(), x) == v2.end(); }); //Exercise 8
+		std::reverse(v3.begin(), v3.end());																	//Exercise 10
+		StringVector markers{ "-", "-", "-", "-" ,"-", "-", "-", "-", "#", "#", "#", "#" ,"-", "-", "-", "-" };
+		std::rotate(markers.begin() + 3, markers.begin() + 8, markers.begin() + 12);						//Exercise 11
+		IntVector numbers{ 1,2,3,4,5,6,7,8,9,10,11,12,13,14 };
+		numbers.erase(std::remove_if(numbers.begin(), numbers.end(), [](int x) { return x % 2 != 0; }), numbers.end()); //Exercise 14
+		numbers.insert(std::lower_bound(numbers.begin(), numbers.end(), 5), 5);								//Exercise 15
+		IntVector wallPoints{ 22,33,19,74 };
+		IntVector lengths{ 2,3,5,6 };
+		int accumulator{ 0 };
+		for (std::size_t i = 0; i < wallPoints.size(); ++i)
+			accumulator = std::max(accumulator, wallPoints[i] - lengths[i] / 4);							//Exercise 16
+		return accumulator + static_cast<int>(v2.size() + v3.size() + numbers.size() + markers.size());
+	}
+
+	//Heap allocations and run time of the exercise patterns with std::vector vs. SmallVector
+	void SmallVectorAllocations()
+	{
+		ExerciseStart t{ "Benchmarks:SmallVectorAllocations" };
+		int const iterations{ 100000 };
+
+		auto const run = [&]<typename IntVector, typename StringVector>(std::string_view const name) {
+			int result{ 0 };
+			Bench::AllocationCount = 0;
+			auto const time{ Bench::Measure([&] {
+				for (int i = 0; i < iterations; ++i)
+					result += ExercisePatterns<IntVector, StringVector>();
+			}, 1) };
+			Bench::DoNotOptimize(result);
+			Bench::Report(name, time);
+			PrintF("  {:<40} {:>12.2f}\n", "allocations per iteration", static_cast<double>(Bench::AllocationCount) / iterations);
+		};
+
+		run.template operator()<std::vector<int, Bench::CountingAllocator<int>>, std::vector<std::string, Bench::CountingAllocator<std::string>>>("std::vector");
+		run.template operator()<Containers::SmallVector<int, 32, Bench::CountingAllocator<int>>, Containers::SmallVector<std::string, 16, Bench::CountingAllocator<std::string>>>("SmallVector");
+
+		//SmallVector works with the Print templates
+		Print(Containers::SmallVector<int, 8>{ 1,2,3,4,5,6,7,8,9 });
+		std::cout << std::endl;
+	}
+
+	//Exercise11/12 at scale: marker strings vs. the packed SelectionList
+	void SelectionBitmap()
+	{
+		ExerciseStart t{ "Benchmarks:SelectionBitmap" };
+		std::size_t const count{ 1 << 22 };
+		std::mt19937 engine{ 42 };
+		std::vector<std::string> markers(count);
+		std::generate(markers.begin(), markers.end(), [&] { return std::string{ engine() % 2 ? "#" : "-" } + std::to_string(engine() % 100); });
+		std::size_t const half{ count / 2 };
+
+		std::vector<std::string> strings;
+		Containers::SelectionList packed;
+		auto const isSelected = [](std::string const& marker) { return marker[0] == '#'; };
+		auto const partitionStrings{ Bench::Measure([&] { strings = markers; }, [&] {
+			std::stable_partition(strings.begin(), strings.begin() + half, [&](auto const& m) { return not isSelected(m); });
+			std::stable_partition(strings.begin() + half, strings.end(), isSelected);
+		}, 3) };
+		auto const partitionPacked{ Bench::Measure([&] { packed = Containers::SelectionList{ markers }; }, [&] {
+			packed.StablePartition(0, half, false);
+			packed.StablePartition(half, count, true);
+		}, 3) };
+		Bench::Check(packed.ToStrings() == strings, "SelectionList::StablePartition matches the strings");
+		Bench::Report("stable partition (std::string)", partitionStrings);
+		Bench::Report("stable partition (SelectionList)", partitionPacked);
+		Bench::ReportSpeedup("stable partition speedup", partitionStrings, partitionPacked);
+
+		std::size_t const blockSize{ count / 4 };
+		auto const moveStrings{ Bench::Measure([&] { std::rotate(strings.begin() + 3, strings.begin() + half, strings.begin() + half + blockSize); }, 3) };
+		auto const movePacked{ Bench::Measure([&] { packed.MoveRange(half, blockSize, 3); }, 3) };
+		Bench::Check(packed.ToStrings() == strings, "SelectionList::MoveRange matches std::rotate");
+		Bench::Report("block move (std::string)", moveStrings);
+		Bench::Report("block move (SelectionList)", movePacked);
+		Bench::ReportSpeedup("block move speedup", moveStrings, movePacked);
+		PrintF("  {:<40} {:>12} vs {:.2f}\n", "bytes per element", sizeof(std::string), packed.BytesPerElement());
+	}
+
+	//Scan throughput vs. std::inclusive_scan, and the scan-based parallel copy_if of Exercise2
+	void PrefixSum()
+	{
+		ExerciseStart t{ "Benchmarks:PrefixSum" };
+		std::size_t const count{ 1 << 26 };
+		auto const source{ Bench::RandomVector<int>(count, -1000, 1000) };
+		std::vector<int> result(count);
+		std::size_t const bytes{ 2 * count * sizeof(int) }; //read + write
+
+		auto const stl{ Bench::Measure([&] { std::inclusive_scan(source.begin(), source.end(), result.begin()); }) };
+		auto const expected{ result };
+		auto const simd{ Bench::Measure([&] { Scan::InclusiveScan(source.begin(), source.end(), result.begin()); }) };
+		Bench::Check(result == expected, "InclusiveScan matches std::inclusive_scan");
+		auto const parallel{ Bench::Measure([&] { Scan::ParallelInclusiveScan(source.begin(), source.end(), result.begin()); }) };
+		Bench::Check(result == expected, "ParallelInclusiveScan matches std::inclusive_scan");
+		Bench::Report("std::inclusive_scan", stl, bytes);
+		Bench::Report("Scan::InclusiveScan (AVX2)", simd, bytes);
+		Bench::Report("Scan::ParallelInclusiveScan", parallel, bytes);
+		Bench::ReportSpeedup("parallel speedup", stl, parallel);
+
+		std::vector<int> copied;
+		auto const isGreater5 = [](int x) { return x > 5; };
+		auto const copyIf{ Bench::Measure([&] { copied.clear(); std::copy_if(source.begin(), source.end(), std::back_inserter(copied), isGreater5); }) };
+		auto const parallelCopyIf{ Bench::Measure([&] { copied = Scan::ParallelCopyIf(source, isGreater5); }) };
+		Bench::Report("std::copy_if", copyIf, count * sizeof(int));
+		Bench::Report("Scan::ParallelCopyIf", parallelCopyIf, count * sizeof(int));
+	}
+
+	//Sorting and counting values from the small domain 1..100 (Exercise9's values)
+	void SmallDomainSort()
+	{
+		ExerciseStart t{ "Benchmarks:SmallDomainSort" };
+		std::size_t const count{ 1 << 24 };
+		auto const source{ Bench::RandomVector<int>(count, 1, 100) };
+		std::vector<int> v;
+
+		auto const stl{ Bench::Measure([&] { v = source; }, [&] { std::sort(v.begin(), v.end()); }, 3) };
+		auto const radix{ Bench::Measure([&] { v = source; }, [&] { FastPath::Sort(v); }, 3) };
+		auto const counting{ Bench::Measure([&] { v = source; }, [&] { Counting::DomainSort(v); }, 3) };
+		Bench::Check(std::ranges::is_sorted(v), "DomainSort output is sorted");
+		Bench::Report("std::sort", stl, count * sizeof(int));
+		Bench::Report("FastPath::Sort (radix)", radix, count * sizeof(int));
+		Bench::Report("Counting::DomainSort", counting, count * sizeof(int));
+		Bench::ReportSpeedup("counting sort speedup", stl, counting);
+
+		std::span<int const> const values{ source };
+		std::vector<std::size_t> bins;
+		auto const minMax{ Bench::Measure([&] { Bench::DoNotOptimize(Counting::MinMax(values)); }) };
+		auto const serial{ Bench::Measure([&] { bins = Counting::Histogram(values, 1, 100); }) };
+		auto const parallel{ Bench::Measure([&] { bins = Counting::ParallelHistogram(values, 1, 100); }) };
+		Bench::Report("Counting::MinMax", minMax, count * sizeof(int));
+		Bench::Report("Counting::Histogram", serial, count * sizeof(int));
+		Bench::Report("Counting::ParallelHistogram", parallel, count * sizeof(int));
+	}
+
+	//Deduplicating an ID vector before an Exercise8-style diff
+	void Deduplication()
+	{
+		ExerciseStart t{ "Benchmarks:Deduplication" };
+		std::size_t const count{ 1 << 24 };
+		auto const source{ Bench::RandomVector<int>(count, 0, static_cast<int>(count / 4)) };
+		std::vector<int> v;
+
+		auto const stl{ Bench::Measure([&] { v = source; }, [&] { std::sort(v.begin(), v.end()); v.erase(std::unique(v.begin(), v.end()), v.end()); }, 3) };
+		auto const expectedSize{ v.size() };
+		auto const sorted{ Bench::Measure([&] { v = source; }, [&] { Dedup::SortAndDedup(v); }, 3) };
+		Bench::Check(v.size() == expectedSize, "SortAndDedup keeps every distinct value once");
+		auto const hashed{ Bench::Measure([&] { v = source; }, [&] { Dedup::ParallelDedup(v); }, 3) };
+		Bench::Check(v.size() == expectedSize, "ParallelDedup keeps every distinct value once");
+		auto const ordered{ Bench::Measure([&] { v = source; }, [&] { Dedup::ParallelDedup(v, true); }, 3) };
+		Bench::Check(v.size() == expectedSize, "ordered ParallelDedup keeps every distinct value once");
+		Bench::Report("std::sort + std::unique + erase", stl, count * sizeof(int));
+		Bench::Report("Dedup::SortAndDedup (radix + SIMD)", sorted, count * sizeof(int));
+		Bench::Report("Dedup::ParallelDedup", hashed, count * sizeof(int));
+		Bench::Report("Dedup::ParallelDedup (first order)", ordered, count * sizeof(int));
+
+		std::vector<int> sortedSource{ source };
+		FastPath::Sort(sortedSource);
+		auto const unique{ Bench::Measure([&] { v = sortedSource; }, [&] { v.erase(std::unique(v.begin(), v.end()), v.end()); }) };
+		auto const simdUnique{ Bench::Measure([&] { v = sortedSource; }, [&] { v.resize(Dedup::UniqueSorted(std::span<int>{ v })); }) };
+		Bench::Report("std::unique on sorted input", unique, count * sizeof(int));
+		Bench::Report("Dedup::UniqueSorted (AVX2)", simdUnique, count * sizeof(int));
+		Bench::ReportSpeedup("unique speedup", unique, simdUnique);
+	}
+
+	//Ingest throughput and accuracy of the streaming sketches, with per-thread sketches merged at the end
+	void StreamingSketches()
+	{
+		ExerciseStart t{ "Benchmarks:StreamingSketches" };
+		std::size_t const count{ 1 << 24 };
+		auto const stream{ Bench::RandomVector<std::uint32_t>(count, 0, 1'000'000) };
+		std::span<std::uint32_t const> const values{ stream };
+		unsigned const threads{ Parallel::ThreadCount() };
+
+		Sketches::HyperLogLog<> distinct;
+		auto const hllTime{ Bench::Measure([&] { distinct.Clear(); }, [&] {
+			std::vector<Sketches::HyperLogLog<>> local(Parallel::PartitionCount(count, threads));
+			Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+				local[index].AddRange(values.subspan(range.Begin, range.End - range.Begin));
+			}, threads);
+			for (auto const& sketch : local)
+				distinct.Merge(sketch);
+		}, 3) };
+		auto exact{ stream };
+		Dedup::SortAndDedup(exact);
+		Bench::Report("HyperLogLog ingest + merge", hllTime, count * sizeof(std::uint32_t));
+		PrintF("  distinct: exact {}, estimate {:.0f} (standard error {:.2f}%)\n", exact.size(), distinct.Estimate(), 100 * Sketches::HyperLogLog<>::StandardError());
+
+		auto frequencies{ Sketches::CountMinSketch::FromErrorBounds(0.0001, 0.01) };
+		auto const cmsTime{ Bench::Measure([&] {
+			std::vector<Sketches::CountMinSketch> local(Parallel::PartitionCount(count, threads), Sketches::CountMinSketch{ frequencies.Width(), frequencies.Depth() });
+			Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+				local[index].AddRange(values.subspan(range.Begin, range.End - range.Begin));
+			}, threads);
+			frequencies = std::move(local[0]);
+			for (std::size_t i = 1; i < local.size(); ++i)
+				frequencies.Merge(local[i]);
+		}, 3) };
+		Bench::Report("Count-Min ingest + merge", cmsTime, count * sizeof(std::uint32_t));
+		auto const exactCount{ std::ranges::count(stream, stream[0]) };
+		PrintF("  frequency of {}: exact {}, estimate {} (bound +{:.0f})\n", stream[0], exactCount, frequencies.Estimate(stream[0]), 0.0001 * frequencies.TotalCount());
+
+		//Exercise7 on a materialized vector, for comparison
+		auto const countIf{ Bench::Measure([&] { Bench::DoNotOptimize(std::count_if(stream.begin(), stream.end(), [](std::uint32_t x) { return x % 2 == 0; })); }) };
+		Bench::Report("std::count_if (Exercise7)", countIf, count * sizeof(std::uint32_t));
+	}
+
+	//Price percentiles of a large catalog: KLL sketch (one per thread, merged) vs. sorting all prices as in Exercise13
+	void PriceQuantiles()
+	{
+		ExerciseStart t{ "Benchmarks:PriceQuantiles" };
+		std::size_t const count{ 1 << 21 };
+		auto const prices{ Bench::RandomVector<double>(count, 1.0, 1000.0) };
+		std::vector<Product> products;
+		products.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			products.emplace_back(Product{ "P" + std::to_string(i), prices[i] * prices[i] / 1000, i % 2 == 0 }); //skewed prices
+
+		std::vector<double> sorted;
+		auto const sortTime{ Bench::Measure([&] {
+			sorted.clear();
+			std::ranges::transform(products, std::back_inserter(sorted), &Product::Price);
+			std::ranges::sort(sorted);
+		}, 3) };
+
+		Sketches::KllSketch sketch;
+		unsigned const threads{ Parallel::ThreadCount() };
+		auto const ingestTime{ Bench::Measure([&] {
+			//One seed per thread: sketches with equal seeds would make the same compaction choices
+			std::vector<Sketches::KllSketch> local;
+			for (unsigned i = 0, partitions = Parallel::PartitionCount(count, threads); i < partitions; ++i)
+				local.emplace_back(Sketches::KllSketch::DefaultK, 42 + i);
+			Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+				local[index].AddRange(std::span{ products }.subspan(range.Begin, range.End - range.Begin), &Product::Price);
+			}, threads);
+			sketch = Sketches::KllSketch{};
+			for (auto const& part : local)
+				sketch.Merge(part);
+		}, 3) };
+		Bench::Report("sort all prices", sortTime);
+		Bench::Report("KLL ingest + merge", ingestTime);
+
+		//Accuracy: rank of the estimated quantile in the exact sorted prices
+		for (double const q : { 0.5, 0.9, 0.99 })
+		{
+			double estimate{ 0 };
+			auto const queryTime{ Bench::Measure([&] { estimate = sketch.Quantile(q); }) };
+			auto const rank{ static_cast<double>(std::ranges::lower_bound(sorted, estimate) - sorted.begin()) / count };
+			PrintF("  p{:<3} exact {:>8.2f}  estimate {:>8.2f}  rank error {:.3f}%  query {:.2f} us\n",
+				q * 100, sorted[static_cast<std::size_t>(q * count)], estimate, 100 * std::abs(rank - q), queryTime / 1000);
+			Bench::Check(std::abs(rank - q) < 0.02, "KLL rank error below 2%");
+		}
+		PrintF("  retained values: {} of {}\n", sketch.RetainedCount(), sketch.Count());
+	}
+
+	//Sorting products by price as in Exercise13, with a data set 4 times the memory budget
+	void ExternalProductSort()
+	{
+		ExerciseStart t{ "Benchmarks:ExternalProductSort" };
+		std::size_t const count{ 1 << 20 };
+		auto const prices{ Bench::RandomVector<double>(count, 1.0, 1000.0) };
+		std::vector<Product> products;
+		products.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			products.emplace_back(Product{ "P" + std::to_string(i), prices[i], i % 3 == 0 });
+		std::size_t const dataBytes{ count * (sizeof(Product) + 8) };
+
+		auto const byPrice = [](Product const& a, Product const& b) { return a.Price() < b.Price(); };
+		std::vector<Product> sorted;
+		auto const inMemory{ Bench::Measure([&] { sorted = products; }, [&] { std::ranges::sort(sorted, byPrice); }, 1) };
+
+		External::SortOptions options;
+		options.MemoryBudget = dataBytes / 4; //the data is 4x the memory we allow ourselves
+		options.MaxOpenFiles = 16;
+		std::size_t runs{ 0 };
+		std::vector<Product> result;
+		auto const external{ Bench::Measure([&] { result.clear(); }, [&] {
+			External::ExternalSorter<Product, decltype(byPrice)> sorter{ options, byPrice };
+			sorter.AddRange(products);
+			runs = sorter.RunCount();
+			sorter.Finish([&](Product const& product) { result.push_back(product); });
+		}, 1) };
+		Bench::Check(std::ranges::equal(result, sorted, [](auto const& a, auto const& b) { return a.Price() == b.Price(); }), "external sort matches std::ranges::stable_sort");
+		Bench::Report("std::sort in memory", inMemory, dataBytes);
+		Bench::Report(std::format("external sort ({} runs)", runs), external, dataBytes);
+	}
+
+	//Exercise8's v1 \ v2 on files: streaming set operations vs. loading both files and using std::set_difference
+	void ExternalSetOperations()
+	{
+		ExerciseStart t{ "Benchmarks:ExternalSetOperations" };
+		std::size_t const count{ 1 << 24 };
+		auto const directory{ std::filesystem::temp_directory_path() };
+		auto const pathA{ directory / "learnstl-v1.bin" };
+		auto const pathB{ directory / "learnstl-v2.bin" };
+		auto const pathOut{ directory / "learnstl-v3.bin" };
+		auto v1{ Bench::RandomVector<int>(count, 0, 1 << 26, 1) };
+		auto v2{ Bench::RandomVector<int>(count, 0, 1 << 26, 2) };
+		External::WriteFile<int>(pathA, v1);
+		External::WriteFile<int>(pathB, v2);
+
+		//Unsorted inputs: external sort first
+		External::SetOperationOptions options;
+		options.SortInputs = true;
+		options.Sort.MemoryBudget = count; //a quarter of each input
+		std::size_t written{ 0 };
+		auto const sortAndDiff{ Bench::Measure([&] { written = External::ApplySetOperation<int>(pathA, pathB, pathOut, External::SetOperation::Difference, options); }, 1) };
+		Bench::Report("external sort + difference", sortAndDiff, 2 * count * sizeof(int));
+
+		//Sorted inputs
+		FastPath::Sort(v1);
+		FastPath::Sort(v2);
+		External::WriteFile<int>(pathA, v1);
+		External::WriteFile<int>(pathB, v2);
+		options.SortInputs = false;
+		for (auto const& [operation, name] : { std::pair{ External::SetOperation::Difference, "difference" }, std::pair{ External::SetOperation::Intersection, "intersection" }, std::pair{ External::SetOperation::Union, "union" } })
+		{
+			auto const time{ Bench::Measure([&] { written = External::ApplySetOperation<int>(pathA, pathB, pathOut, operation, options); }, 3) };
+			Bench::Report(std::format("streaming {} ({} values)", name, written), time, 2 * count * sizeof(int));
+		}
+
+		std::vector<int> v3;
+		auto const inMemory{ Bench::Measure([&] {
+			auto const a{ External::ReadFile<int>(pathA) };
+			auto const b{ External::ReadFile<int>(pathB) };
+			v3.clear();
+			std::ranges::set_difference(a, b, std::back_inserter(v3));
+			External::WriteFile<int>(pathOut, v3);
+		}, 3) };
+		Bench::Report("load + std::set_difference + write", inMemory, 2 * count * sizeof(int));
+
+		for (auto const& path : { pathA, pathB, pathOut })
+			std::filesystem::remove(path);
+	}
+
+	//Time to first query: rebuilding the Eytzinger index vs. mapping a saved one
+	void SearchIndexPersistence()
+	{
+		ExerciseStart t{ "Benchmarks:SearchIndexPersistence" };
+		std::size_t const count{ 1 << 24 };
+		auto const path{ std::filesystem::temp_directory_path() / "learnstl-index.bin" };
+		auto data{ Bench::RandomVector<int>(count, 0, 1 << 30, 1) };
+		FastPath::Sort(data);
+		std::span<int const> const sorted{ data };
+		Indexes::EytzingerIndex<int>{ sorted }.Save(path);
+		auto const query{ data[count / 3] };
+		auto const expected{ static_cast<std::size_t>(Misc::BinarySearch(data.begin(), data.end(), query) - data.begin()) };
+
+		std::size_t found{ 0 };
+		auto const rebuild{ Bench::Measure([&] { found = Indexes::EytzingerIndex<int>{ sorted }.LowerBound(query); }, 3) };
+		Bench::Check(found == expected, "rebuilt index finds the expected position");
+		auto const load{ Bench::Measure([&] { found = Indexes::EytzingerIndex<int>::Load(path).LowerBound(query); }, 3) };
+		Bench::Check(found == expected, "loaded index finds the expected position");
+		auto const validated{ Bench::Measure([&] {
+			auto const index{ Indexes::EytzingerIndex<int>::Load(path) };
+			if (not index.Matches(sorted))
+				throw std::runtime_error{ "stale index" };
+			found = index.LowerBound(query);
+		}, 3) };
+		auto const verified{ Bench::Measure([&] { found = Indexes::EytzingerIndex<int>::Load(path, true).LowerBound(query); }, 3) };
+		Bench::Report("rebuild + first query", rebuild);
+		Bench::Report("map + first query", load);
+		Bench::Report("map + source hash check + first query", validated);
+		Bench::Report("map + checksum check + first query", verified);
+		Bench::ReportSpeedup("map vs. rebuild", rebuild, load);
+
+		//Steady state: the layout also beats the recursive binary search
+		auto const queries{ Bench::RandomVector<int>(1 << 20, 0, 1 << 30, 2) };
+		auto const index{ Indexes::EytzingerIndex<int>::Load(path) };
+		std::size_t sum{ 0 };
+		auto const binary{ Bench::Measure([&] { for (auto const q : queries) sum += static_cast<std::size_t>(Misc::BinarySearch(data.begin(), data.end(), q) - data.begin()); }, 3) };
+		auto const eytzinger{ Bench::Measure([&] { for (auto const q : queries) sum += index.LowerBound(q); }, 3) };
+		Bench::DoNotOptimize(sum);
+		Bench::Report("Misc::BinarySearch (1M queries)", binary);
+		Bench::Report("EytzingerIndex::LowerBound (1M queries)", eytzinger);
+		Bench::ReportSpeedup("Eytzinger vs. BinarySearch", binary, eytzinger);
+		std::filesystem::remove(path);
+	}
+
+	//Exercise15's sorted insert at scale: LSM store vs. std::map vs. inserting into a sorted vector
+	void LsmIngest()
+	{
+		ExerciseStart t{ "Benchmarks:LsmIngest" };
+		std::size_t const count{ 1 << 21 };
+		auto const keys{ Bench::RandomVector<int>(count, 0, 1 << 22, 1) };
+		auto const isErase = [](std::size_t const i) { return i % 4 == 3; }; //every fourth operation deletes
+
+		std::map<int, int> map;
+		auto const mapIngest{ Bench::Measure([&] { map.clear(); }, [&] {
+			for (std::size_t i = 0; i < count; ++i)
+				if (isErase(i))
+					map.erase(keys[i]);
+				else
+					map.insert_or_assign(keys[i], static_cast<int>(i));
+		}, 1) };
+
+		std::optional<Containers::LsmStore<int, int>> store;
+		auto const lsmIngest{ Bench::Measure([&] { store.reset(); store.emplace(); }, [&] {
+			for (std::size_t i = 0; i < count; ++i)
+				if (isErase(i))
+					store->Erase(keys[i]);
+				else
+					store->Put(keys[i], static_cast<int>(i));
+		}, 1) };
+		store->WaitForCompaction();
+
+		//Exercise15 style, on 1/32 of the operations: the cost per insert grows with the vector
+		std::size_t const vectorCount{ count / 32 };
+		std::vector<std::pair<int, int>> sortedVector;
+		auto const vectorIngest{ Bench::Measure([&] { sortedVector.clear(); }, [&] {
+			for (std::size_t i = 0; i < vectorCount; ++i)
+			{
+				auto const position{ std::ranges::lower_bound(sortedVector, keys[i], {}, &std::pair<int, int>::first) };
+				bool const found{ position != sortedVector.end() and position->first == keys[i] };
+				if (isErase(i))
+				{
+					if (found)
+						sortedVector.erase(position);
+				}
+				else if (found)
+					position->second = static_cast<int>(i);
+				else
+					sortedVector.insert(position, { keys[i], static_cast<int>(i) });
+			}
+		}, 1) };
+		Bench::Report(std::format("sorted vector ({} ops)", vectorCount), vectorIngest);
+		Bench::Report(std::format("std::map ({} ops)", count), mapIngest);
+		Bench::Report(std::format("LsmStore ({} ops, {} runs)", count, store->RunCount()), lsmIngest);
+		Bench::ReportSpeedup("LsmStore vs. std::map ingest", mapIngest, lsmIngest);
+
+		//Point reads (half of them misses, which the Bloom filters answer) and a full ordered scan
+		auto const queries{ Bench::RandomVector<int>(1 << 20, 0, 1 << 23, 2) };
+		std::size_t hits{ 0 };
+		auto const mapGet{ Bench::Measure([&] { hits = 0; for (auto const q : queries) hits += map.contains(q); }, 3) };
+		std::size_t lsmHits{ 0 };
+		auto const lsmGet{ Bench::Measure([&] { lsmHits = 0; for (auto const q : queries) lsmHits += store->Contains(q); }, 3) };
+		Bench::Check(hits == lsmHits, "LsmStore finds the same keys as std::map");
+		std::int64_t sum{ 0 };
+		auto const mapScan{ Bench::Measure([&] { sum = 0; for (auto const& [key, value] : map) sum += value; }, 3) };
+		std::int64_t lsmSum{ 0 };
+		auto const lsmScan{ Bench::Measure([&] { lsmSum = 0; store->ForEach([&](int, int const value) { lsmSum += value; }); }, 3) };
+		Bench::Check(sum == lsmSum, "LsmStore scan sums the same values as std::map");
+		Bench::Report("std::map lookups (1M)", mapGet);
+		Bench::Report("LsmStore lookups (1M)", lsmGet);
+		Bench::Report("std::map ordered scan", mapScan);
+		Bench::Report("LsmStore ordered scan", lsmScan);
+	}
+
+	//Product lookup by name: Swiss table with std::string_view keys vs. std::unordered_map<std::string, Product>
+	void ProductLookup()
+	{
+		ExerciseStart t{ "Benchmarks:ProductLookup" };
+		std::size_t const count{ 1 << 20 };
+		auto const prices{ Bench::RandomVector<double>(count, 1.0, 1000.0, 1) };
+		std::vector<Product> products;
+		products.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			products.emplace_back(Product{ std::format("Product {:08}", i * 7919 % count), prices[i], i % 3 == 0 });
+		//Queries arrive as views into a request buffer; half of them are unknown names
+		auto const picks{ Bench::RandomVector<std::size_t>(count, 0, 2 * count - 1, 2) };
+		std::string requests;
+		std::vector<std::string_view> queries;
+		for (auto const pick : picks)
+			requests += std::format("Product {:08}", pick);
+		for (std::size_t i = 0; i < count; ++i)
+			queries.emplace_back(requests.data() + 16 * i, 16);
+
+		std::unordered_map<std::string, Product> unordered;
+		auto const unorderedBuild{ Bench::Measure([&] { unordered = {}; }, [&] {
+			unordered.reserve(count);
+			for (auto const& product : products)
+				unordered.try_emplace(product.Name(), product);
+		}, 3) };
+		Containers::SwissMap<std::string, Product> swiss;
+		auto const swissBuild{ Bench::Measure([&] { swiss.Clear(); }, [&] { swiss.InsertRange(products, &Product::Name); }, 3) };
+		Bench::Check(swiss.Size() == unordered.size(), "SwissMap holds every product");
+
+		double unorderedSum{ 0 };
+		auto const unorderedFind{ Bench::Measure([&] {
+			unorderedSum = 0;
+			for (auto const query : queries)
+				if (auto const it{ unordered.find(std::string{ query }) }; it != unordered.end()) //allocates: the names do not fit the small string buffer
+					unorderedSum += it->second.Price();
+		}, 3) };
+		double swissSum{ 0 };
+		auto const swissFind{ Bench::Measure([&] {
+			swissSum = 0;
+			for (auto const query : queries)
+				if (auto const product{ swiss.Find(query) })
+					swissSum += product->Price();
+		}, 3) };
+		Bench::Check(unorderedSum == swissSum, "SwissMap finds the same prices as std::unordered_map");
+
+		Bench::Report("std::unordered_map build", unorderedBuild);
+		Bench::Report("SwissMap bulk build", swissBuild);
+		Bench::Report("std::unordered_map find (1M)", unorderedFind);
+		Bench::Report("SwissMap find by string_view (1M)", swissFind);
+		Bench::ReportSpeedup("SwissMap vs. unordered_map find", unorderedFind, swissFind);
+		PrintF("  {:<40} {:>12.1f} MB\n", "SwissMap memory", static_cast<double>(swiss.ByteSize()) / (1 << 20));
+	}
+
+	//Type-ahead on Product::Name(): adaptive radix tree vs. scanning all products vs. a sorted name vector
+	void TypeAhead()
+	{
+		ExerciseStart t{ "Benchmarks:TypeAhead" };
+		std::size_t const count{ 1 << 20 };
+		std::size_t const suggestions{ 10 };
+		std::array<std::string_view, 8> const brands{ "Acme", "Bolt", "Contoso", "Dyna", "Evergreen", "Fabrikam", "Globex", "Initech" };
+		std::array<std::string_view, 6> const kinds{ "Cable", "Charger", "Headset", "Keyboard", "Monitor", "Mouse" };
+		auto const ids{ Bench::RandomVector<std::uint32_t>(count, 0, 99'999'999, 1) };
+		std::vector<Product> products;
+		products.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			products.emplace_back(Product{ std::format("{} {} {:08}", brands[i % brands.size()], kinds[i / 8 % kinds.size()], ids[i]), 1.0, false });
+
+		//Sorted, unique names with their product index
+		std::vector<std::string> names;
+		std::vector<std::uint32_t> order;
+		auto const sortTime{ Bench::Measure([&] {
+			std::vector<std::pair<std::string, std::uint32_t>> named;
+			named.reserve(count);
+			for (std::size_t i = 0; i < count; ++i)
+				named.emplace_back(products[i].Name(), static_cast<std::uint32_t>(i));
+			std::ranges::sort(named);
+			auto const duplicates{ std::ranges::unique(named, {}, &std::pair<std::string, std::uint32_t>::first) };
+			named.erase(duplicates.begin(), duplicates.end());
+			names.clear();
+			order.clear();
+			for (auto& [name, index] : named)
+			{
+				names.push_back(std::move(name));
+				order.push_back(index);
+			}
+		}, 1) };
+		std::optional<Indexes::AdaptiveRadixTree<std::uint32_t>> tree;
+		auto const buildTime{ Bench::Measure([&] { tree = Indexes::AdaptiveRadixTree<std::uint32_t>::BulkLoad(std::span<std::string const>{ names }, std::span<std::uint32_t const>{ order }); }, 1) };
+		Indexes::AdaptiveRadixTree<std::uint32_t> inserted;
+		auto const insertTime{ Bench::Measure([&] { for (std::size_t i = 0; i < count; ++i) inserted.Insert(products[i].Name(), static_cast<std::uint32_t>(i)); }, 1) };
+		Bench::Report("sort names", sortTime);
+		Bench::Report("ART bulk load from sorted names", buildTime);
+		Bench::Report("ART single inserts", insertTime);
+
+		auto const stats{ tree->Stats() };
+		std::size_t vectorBytes{ names.capacity() * sizeof(std::string) };
+		for (auto const& name : names)
+			vectorBytes += name.capacity() > std::string{}.capacity() ? name.capacity() + 1 : 0;
+		PrintF("  {:<40} {:>12.1f} MB ({} leaves, {}/{}/{}/{} nodes 4/16/48/256)\n", "ART memory", static_cast<double>(stats.Bytes) / (1 << 20), stats.Leaves, stats.Node4, stats.Node16, stats.Node48, stats.Node256);
+		PrintF("  {:<40} {:>12.1f} MB\n", "sorted name vector memory", static_cast<double>(vectorBytes) / (1 << 20));
+
+		//Queries: the first 3 to 12 characters of random names, as typed
+		auto const picks{ Bench::RandomVector<std::size_t>(10'000, 0, names.size() - 1, 2) };
+		auto const lengths{ Bench::RandomVector<std::size_t>(picks.size(), 3, 12, 3) };
+		std::vector<std::string> queries;
+		for (std::size_t i = 0; i < picks.size(); ++i)
+			queries.push_back(names[picks[i]].substr(0, lengths[i]));
+
+		std::size_t found{ 0 };
+		auto const artLatencies{ Bench::MeasureLatencies(queries.size(), [&](std::size_t const i) {
+			found += tree->PrefixSearch(queries[i], suggestions).size();
+		}) };
+		std::size_t vectorFound{ 0 };
+		auto const vectorLatencies{ Bench::MeasureLatencies(queries.size(), [&](std::size_t const i) {
+			auto it{ std::ranges::lower_bound(names, queries[i]) };
+			for (std::size_t n = 0; n < suggestions and it != names.end() and it->starts_with(queries[i]); ++n, ++it)
+				++vectorFound;
+		}) };
+		Bench::Check(found == vectorFound, "radix tree finds the same names as the sorted vector");
+		std::size_t scanFound{ 0 };
+		auto const scanLatencies{ Bench::MeasureLatencies(100, [&](std::size_t const i) {
+			for (auto const& product : products)
+				scanFound += product.Name().starts_with(queries[i]);
+		}) };
+		Bench::DoNotOptimize(scanFound);
+		Bench::ReportLatencies("ART prefix search (10 results)", artLatencies);
+		Bench::ReportLatencies("sorted vector lower_bound (10 results)", vectorLatencies);
+		Bench::ReportLatencies("scan all products", scanLatencies);
+	}
+
+	//Substring search ("contains") on product names: trigram index vs. scanning all names
+	void SubstringSearch()
+	{
+		ExerciseStart t{ "Benchmarks:SubstringSearch" };
+		std::size_t const count{ 1 << 21 };
+		std::array<std::string_view, 8> const brands{ "Acme", "Bolt", "Contoso", "Dyna", "Evergreen", "Fabrikam", "Globex", "Initech" };
+		std::array<std::string_view, 8> const kinds{ "Cable", "Charger", "Headset", "Keyboard", "Monitor", "Mouse", "Projector", "Speaker" };
+		std::array<std::string_view, 6> const grades{ "Pro", "Max", "Mini", "Plus", "Lite", "Ultra" };
+		auto const picks{ Bench::RandomVector<std::uint32_t>(3 * count, 0, 1'000'000, 1) };
+		std::vector<std::string> names;
+		names.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			names.push_back(std::format("{} {} {} {}", brands[picks[3 * i] % 8], kinds[picks[3 * i + 1] % 8], grades[picks[3 * i + 2] % 6], picks[3 * i] % 100'000));
+
+		std::optional<Indexes::TrigramIndex> index;
+		auto const build{ Bench::Measure([&] { index.emplace(names); }, 1) };
+		Bench::Report("trigram index bulk build", build);
+		PrintF("  {:<40} {:>12.1f} MB ({:.2f} bytes per id, {} trigrams)\n", "compressed posting lists", static_cast<double>(index->PostingBytes()) / (1 << 20),
+			static_cast<double>(index->PostingBytes()) / static_cast<double>(index->PostingCount()), index->TrigramCount());
+
+		std::vector<std::string> const queries{ "pro", "Keyboard", "globex mon", "ultra 123", "max 9999", "ger pl", "ProJ", "speaker lite 42" };
+		std::size_t found{ 0 };
+		auto const indexLatencies{ Bench::MeasureLatencies(100 * queries.size(), [&](std::size_t const i) { found += index->Search(queries[i % queries.size()]).size(); }) };
+		std::size_t scanned{ 0 };
+		auto const scanLatencies{ Bench::MeasureLatencies(queries.size(), [&](std::size_t const i) {
+			std::string query{ queries[i] };
+			std::ranges::transform(query, query.begin(), [](unsigned char const c) { return static_cast<char>(std::tolower(c)); });
+			for (auto const& name : names)
+			{
+				std::string folded{ name };
+				std::ranges::transform(folded, folded.begin(), [](unsigned char const c) { return static_cast<char>(std::tolower(c)); });
+				scanned += folded.find(query) != std::string::npos;
+			}
+		}) };
+		Bench::Check(found == 100 * scanned, "trigram index finds every name containing the pattern");
+		Bench::ReportLatencies("trigram index search", indexLatencies);
+		Bench::ReportLatencies("scan all names", scanLatencies);
+
+		//Incremental maintenance: new products and removed products between compactions
+		auto const added{ Bench::Measure([&] {
+			for (std::size_t i = 0; i < 100'000; ++i)
+				index->Add(static_cast<std::uint32_t>(count + i), names[i]);
+		}, 1) };
+		auto const removed{ Bench::Measure([&] {
+			for (std::size_t i = 0; i < 100'000; ++i)
+				index->Remove(static_cast<std::uint32_t>(2 * i));
+		}, 1) };
+		auto const compact{ Bench::Measure([&] { index->Compact(); }, 1) };
+		Bench::Report("add 100000 names", added);
+		Bench::Report("remove 100000 names", removed);
+		Bench::Report("compaction", compact);
+		auto const afterLatencies{ Bench::MeasureLatencies(100 * queries.size(), [&](std::size_t const i) { found += index->Search(queries[i % queries.size()]).size(); }) };
+		Bench::ReportLatencies("trigram index search after updates", afterLatencies);
+	}
+
+	//Near-duplicate product names (edit distance <= 2): dynamic program vs. Myers vs. length filter + SIMD lanes vs. BK-tree
+	void NearDuplicateNames()
+	{
+		ExerciseStart t{ "Benchmarks:NearDuplicateNames" };
+		std::size_t const count{ 1 << 20 };
+		std::size_t const maxDistance{ 2 };
+		std::array<std::string_view, 8> const brands{ "Acme", "Bolt", "Contoso", "Dyna", "Evergreen", "Fabrikam", "Globex", "Initech" };
+		std::array<std::string_view, 6> const kinds{ "Cable", "Charger", "Headset", "Keyboard", "Monitor", "Mouse" };
+		auto const picks{ Bench::RandomVector<std::uint32_t>(2 * count, 0, 9'999'999, 1) };
+		std::vector<std::string> names;
+		names.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			names.push_back(std::format("{} {} {}", brands[picks[2 * i] % 8], kinds[picks[2 * i + 1] % 6], picks[2 * i] / 8));
+		//Queries: existing names with one typo
+		std::vector<std::string> queries;
+		for (std::size_t i = 0; i < 200; ++i)
+		{
+			std::string query{ names[i * 4999 % count] };
+			query[i % query.size()] = 'x';
+			queries.push_back(std::move(query));
+		}
+
+		std::optional<Similarity::LengthIndex> lengthIndex;
+		auto const lengthBuild{ Bench::Measure([&] { lengthIndex.emplace(names); }, 1) };
+		std::optional<Similarity::BkTree> bkTree;
+		auto const bkBuild{ Bench::Measure([&] { bkTree.emplace(names); }, 1) };
+		Bench::Report("length index build", lengthBuild);
+		Bench::Report("BK-tree build", bkBuild);
+
+		//The fast methods must find exactly the names the dynamic program finds
+		std::vector<std::vector<std::uint32_t>> expected(queries.size());
+		auto const dpLatencies{ Bench::MeasureLatencies(2, [&](std::size_t const q) {
+			for (std::uint32_t id = 0; id < count; ++id)
+				if (Similarity::Levenshtein(queries[q], names[id]) <= maxDistance)
+					expected[q].push_back(id);
+		}) };
+		auto const myersLatencies{ Bench::MeasureLatencies(20, [&](std::size_t const q) {
+			Similarity::MyersPattern const pattern{ queries[q] };
+			std::vector<std::uint32_t> found;
+			for (std::uint32_t id = 0; id < count; ++id)
+				if (pattern.Distance(names[id], maxDistance) <= maxDistance)
+					found.push_back(id);
+			Bench::Check(q >= 2 or found == expected[q], "Myers distance matches the expected matches");
+			expected[q] = std::move(found);
+		}) };
+		auto const lengthLatencies{ Bench::MeasureLatencies(queries.size(), [&](std::size_t const q) {
+			auto const found{ lengthIndex->Within(queries[q], maxDistance) };
+			Bench::Check(q >= 20 or found == expected[q], "length index matches the expected matches");
+			Bench::DoNotOptimize(found);
+		}) };
+		auto const bkLatencies{ Bench::MeasureLatencies(queries.size(), [&](std::size_t const q) {
+			auto const found{ bkTree->Within(queries[q], maxDistance) };
+			Bench::Check(q >= 20 or found == expected[q], "BK-tree matches the expected matches");
+			Bench::DoNotOptimize(found);
+		}) };
+		Bench::ReportLatencies("dynamic program, all names", dpLatencies);
+		Bench::ReportLatencies("Myers + early exit, all names", myersLatencies);
+		Bench::ReportLatencies("length filter + 4 SIMD lanes", lengthLatencies);
+		Bench::ReportLatencies("BK-tree", bkLatencies);
+	}
+
+	//Sorting Products by Name() and Price(): projections in std::ranges::sort vs. SortByKey (projection once per element)
+	void SortProductsByKey()
+	{
+		ExerciseStart t{ "Benchmarks:SortProductsByKey" };
+		std::size_t const count{ 1 << 20 };
+		auto const prices{ Bench::RandomVector<double>(count, 1.0, 1000.0, 1) };
+		auto const ids{ Bench::RandomVector<std::uint32_t>(count, 0, 99'999'999, 2) };
+		std::vector<Product> products;
+		products.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			products.emplace_back(Product{ std::format("Product {:08}", ids[i]), prices[i], i % 3 == 0 });
+
+		std::vector<Product> sorted;
+		std::vector<Product> byKey;
+		auto const nameSort{ Bench::Measure([&] { sorted = products; }, [&] { std::ranges::stable_sort(sorted, {}, &Product::Name); }, 1) };
+		auto const nameByKey{ Bench::Measure([&] { byKey = products; }, [&] { FastPath::SortByKey(byKey, &Product::Name); }, 3) };
+		Bench::Check(sorted == byKey, "SortByKey by name matches std::ranges::stable_sort");
+		Bench::Report("stable_sort by Name()", nameSort);
+		Bench::Report("SortByKey by Name()", nameByKey);
+		Bench::ReportSpeedup("SortByKey vs. stable_sort (Name)", nameSort, nameByKey);
+
+		auto const priceSort{ Bench::Measure([&] { sorted = products; }, [&] { std::ranges::stable_sort(sorted, {}, &Product::Price); }, 3) };
+		auto const priceByKey{ Bench::Measure([&] { byKey = products; }, [&] { FastPath::SortByKey(byKey, &Product::Price); }, 3) };
+		Bench::Check(sorted == byKey, "SortByKey by price matches std::ranges::stable_sort");
+		Bench::Report("stable_sort by Price()", priceSort);
+		Bench::Report("SortByKey by Price()", priceByKey);
+		Bench::ReportSpeedup("SortByKey vs. stable_sort (Price)", priceSort, priceByKey);
+	}
+
+	//Applying a random permutation to 8 and 64 byte elements: plain gather vs. the Permutations engines
+	template<typename T>
+	void ApplyPermutation(std::string_view const label, std::size_t const count)
+	{
+		std::vector<T> values(count);
+		for (std::size_t i = 0; i < count; ++i)
+			std::memcpy(&values[i], &i, sizeof(i));
+		std::vector<std::uint32_t> order(count);
+		std::iota(order.begin(), order.end(), std::uint32_t{ 0 });
+		std::shuffle(order.begin(), order.end(), std::mt19937_64{ 7 });
+		auto const check = [&](std::vector<T> const& permuted) {
+			for (std::size_t i = 0; i < count; i += 997)
+			{
+				std::size_t origin{ 0 };
+				std::memcpy(&origin, &permuted[i], sizeof(origin));
+				Bench::Check(origin == order[i], "permuted element comes from its source position");
+			}
+		};
+
+		std::vector<T> work;
+		auto const plain{ Bench::Measure([&] { work = values; }, [&] {
+			std::vector<T> gathered;
+			gathered.reserve(count);
+			for (auto const index : order)
+				gathered.push_back(std::move(work[index]));
+			work.swap(gathered);
+		}, 3) };
+		check(work);
+		auto const gather{ Bench::Measure([&] { work = values; }, [&] { Permutations::Gather(work, order); }, 3) };
+		check(work);
+		auto const inPlace{ Bench::Measure([&] { work = values; }, [&] { Permutations::ApplyInPlace(std::span{ work }, order); }, 3) };
+		check(work);
+
+		//The same permutation in scatter form, as a partition or counting pass would produce it
+		auto const destinations{ Permutations::Invert(order) };
+		std::vector<T> target(count);
+		auto const plainScatter{ Bench::Measure([&] {
+			for (std::size_t i = 0; i < count; ++i)
+				target[destinations[i]] = values[i];
+		}, 3) };
+		check(target);
+		auto const bucketed{ Bench::Measure([&] { Permutations::BucketedScatter<T>(values, destinations, target); }, 3) };
+		check(target);
+		auto const scatter{ Bench::Measure([&] { work = values; }, [&] { Permutations::Scatter(work, destinations); }, 3) };
+		check(work);
+
+		std::size_t const bytes{ count * sizeof(T) };
+		Bench::Report(std::format("{}: plain gather", label), plain, bytes);
+		Bench::Report(std::format("{}: prefetched gather", label), gather, bytes);
+		Bench::Report(std::format("{}: in place (cycles + bitmap)", label), inPlace, bytes);
+		Bench::Report(std::format("{}: plain scatter", label), plainScatter, bytes);
+		Bench::Report(std::format("{}: bucketed scatter", label), bucketed, bytes);
+		Bench::Report(std::format("{}: Scatter (engine choice)", label), scatter, bytes);
+		Bench::ReportSpeedup(std::format("{}: prefetched vs. plain gather", label), plain, gather);
+		Bench::ReportSpeedup(std::format("{}: bucketed vs. plain scatter", label), plainScatter, bucketed);
+	}
+
+	void PermutationApply()
+	{
+		ExerciseStart t{ "Benchmarks:PermutationApply" };
+		struct Line { std::uint64_t Words[8]; };
+		static_assert(sizeof(Line) == 64);
+		ApplyPermutation<std::uint64_t>("8 byte", 1 << 23);
+		ApplyPermutation<Line>("64 byte", 1 << 21);
+	}
+
+	//The same lower bound query against 48 sorted per-warehouse vectors: k binary searches vs. one fractional cascade
+	void ShardSearch()
+	{
+		ExerciseStart t{ "Benchmarks:ShardSearch" };
+		std::size_t const shardCount{ 48 };
+		std::size_t const queryCount{ 1 << 17 };
+		auto const sizes{ Bench::RandomVector<std::uint32_t>(shardCount, 10'000, 200'000, 1) };
+		std::vector<std::vector<std::uint32_t>> shards;
+		for (std::size_t i = 0; i < shardCount; ++i)
+		{
+			shards.push_back(Bench::RandomVector<std::uint32_t>(sizes[i], 0, 99'999'999, static_cast<unsigned>(i + 2)));
+			std::ranges::sort(shards.back());
+		}
+		std::vector<std::span<std::uint32_t const>> spans(shards.begin(), shards.end());
+		auto const queries{ Bench::RandomVector<std::uint32_t>(queryCount, 0, 100'000'000, 99) };
+
+		Indexes::FractionalCascade<std::uint32_t> cascade;
+		auto const build{ Bench::Measure([&] { cascade = Indexes::FractionalCascade<std::uint32_t>{ spans }; }, 3) };
+
+		std::vector<std::size_t> expected(queryCount * shardCount);
+		auto const repeated{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < queryCount; ++q)
+				for (std::size_t i = 0; i < shardCount; ++i)
+					expected[q * shardCount + i] = static_cast<std::size_t>(Misc::BinarySearch(shards[i].begin(), shards[i].end(), queries[q]) - shards[i].begin());
+		}, 1) };
+		auto const lowerBound{ Bench::Measure([&] {
+			std::size_t sum{ 0 };
+			for (auto const query : queries)
+				for (auto const& shard : shards)
+					sum += static_cast<std::size_t>(std::ranges::lower_bound(shard, query) - shard.begin());
+			Bench::DoNotOptimize(sum);
+		}, 3) };
+		std::vector<std::size_t> positions(queryCount * shardCount);
+		auto const cascaded{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < queryCount; ++q)
+				cascade.LowerBounds(queries[q], std::span{ positions }.subspan(q * shardCount, shardCount));
+		}, 3) };
+		Bench::Check(positions == expected, "cascade lower bounds match the binary searches");
+		auto const batched{ Bench::Measure([&] { cascade.LowerBounds(queries, positions); }, 3) };
+		Bench::Check(positions == expected, "batched cascade lower bounds match the binary searches");
+
+		Bench::Report("Build cascade", build);
+		Bench::Report("Repeated Misc::BinarySearch", repeated);
+		Bench::Report("Repeated std::lower_bound", lowerBound);
+		Bench::Report("FractionalCascade::LowerBounds", cascaded);
+		Bench::Report("FractionalCascade::LowerBounds (batch)", batched);
+		Bench::ReportSpeedup("Cascade vs. repeated BinarySearch", repeated, cascaded);
+		Bench::ReportSpeedup("Cascade vs. repeated lower_bound", lowerBound, cascaded);
+		Bench::ReportSpeedup("Batched cascade vs. repeated lower_bound", lowerBound, batched);
+		PrintF("  {:<40} {:>12.2f}\n", "Cascade entries per shard element", static_cast<double>(cascade.EntryCount()) / static_cast<double>(std::accumulate(sizes.begin(), sizes.end(), std::size_t{ 0 })));
+
+		//A rebuild touches the levels up to the changed shard only
+		auto const rebuildLast{ Bench::Measure([&] { cascade.Rebuild(shardCount - 1, shards.back()); }, 3) };
+		auto const rebuildFirst{ Bench::Measure([&] { cascade.Rebuild(0, shards.front()); }, 3) };
+		Bench::Report("Rebuild last shard", rebuildLast);
+		Bench::Report("Rebuild first shard", rebuildFirst);
+	}
+
+	//Maximum of wallPoints[i] - lengths[i] / 4 (ContainerAlgorithm::Exercise16) over random subranges: scan vs. RMQ indexes
+	void RangeMaximum()
+	{
+		ExerciseStart t{ "Benchmarks:RangeMaximum" };
+		std::size_t const count{ 1 << 22 };
+		std::size_t const queryCount{ 1 << 20 };
+		auto const wallPoints{ Bench::RandomVector<int>(count, 0, 1'000'000, 1) };
+		auto const lengths{ Bench::RandomVector<int>(count, 1, 1000, 2) };
+		auto const height = [&](std::size_t const i) { return wallPoints[i] - lengths[i] / 4; };
+		auto const starts{ Bench::RandomVector<std::size_t>(queryCount, 0, count - 1, 3) };
+		auto const lengthsOfQueries{ Bench::RandomVector<std::size_t>(queryCount, 1, count, 4) };
+		std::vector<std::pair<std::size_t, std::size_t>> queries(queryCount);
+		for (std::size_t q = 0; q < queryCount; ++q)
+			queries[q] = { starts[q], std::min(count, starts[q] + (q % 2 == 0 ? 1 + lengthsOfQueries[q] % 1000 : lengthsOfQueries[q])) };
+
+		RangeQueries::SparseTable<int, std::greater<>> table;
+		RangeQueries::BlockRangeQuery<int, std::greater<>> blocks;
+		auto const buildTable{ Bench::Measure([&] { table = { std::views::iota(std::size_t{ 0 }, count), height }; }, 1) };
+		auto const buildBlocks{ Bench::Measure([&] { blocks = { std::views::iota(std::size_t{ 0 }, count), height }; }, 1) };
+
+		//The scan answers a small sample only: a query over millions of elements takes milliseconds
+		std::size_t const scanCount{ 200 };
+		std::vector<int> expected(scanCount);
+		auto const scan{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < scanCount; ++q)
+			{
+				int best{ std::numeric_limits<int>::min() };
+				for (std::size_t i = queries[q].first; i < queries[q].second; ++i)
+					best = std::max(best, height(i));
+				expected[q] = best;
+			}
+		}, 1) };
+		for (std::size_t q = 0; q < scanCount; ++q)
+			Bench::Check(table.Query(queries[q].first, queries[q].second) == expected[q] and blocks.Query(queries[q].first, queries[q].second) == expected[q], "range maximum matches the scan");
+
+		std::vector<int> results(queryCount);
+		auto const tableQueries{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < queryCount; ++q)
+				results[q] = table.Query(queries[q].first, queries[q].second);
+		}, 3) };
+		auto const blockQueries{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < queryCount; ++q)
+				results[q] = blocks.Query(queries[q].first, queries[q].second);
+		}, 3) };
+
+		Bench::Report("Build SparseTable", buildTable);
+		Bench::Report("Build BlockRangeQuery", buildBlocks);
+		Bench::Report(std::format("Scan, {} queries", scanCount), scan);
+		Bench::Report(std::format("SparseTable, {} queries", queryCount), tableQueries);
+		Bench::Report(std::format("BlockRangeQuery, {} queries", queryCount), blockQueries);
+		Bench::ReportSpeedup("SparseTable vs. scan (per query)", scan / scanCount, tableQueries / queryCount);
+		Bench::ReportSpeedup("BlockRangeQuery vs. scan (per query)", scan / scanCount, blockQueries / queryCount);
+		PrintF("  {:<40} {:>12.1f} MB\n", "SparseTable memory", static_cast<double>(table.ByteSize()) / (1 << 20));
+		PrintF("  {:<40} {:>12.1f} MB (+ {:.1f} MB values)\n", "BlockRangeQuery index memory", static_cast<double>(blocks.IndexByteSize()) / (1 << 20), static_cast<double>(count * sizeof(int)) / (1 << 20));
+
+		Bench::ReportLatencies("SparseTable query latency", Bench::MeasureLatencies(queryCount, [&](std::size_t const q) {
+			Bench::DoNotOptimize(table.Query(queries[q].first, queries[q].second));
+		}));
+		Bench::ReportLatencies("BlockRangeQuery query latency", Bench::MeasureLatencies(queryCount, [&](std::size_t const q) {
+			Bench::DoNotOptimize(blocks.Query(queries[q].first, queries[q].second));
+		}));
+	}
+
+	//Range sums of Price() over a price-sorted catalog while prices change: accumulate vs. Fenwick and segment tree
+	void PriceRangeSums()
+	{
+		ExerciseStart t{ "Benchmarks:PriceRangeSums" };
+		std::size_t const count{ 1 << 22 };
+		std::size_t const operationCount{ 1 << 20 };
+		auto const prices{ Bench::RandomVector<double>(count, 1.0, 1000.0, 1) };
+		std::vector<Product> catalog;
+		catalog.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			catalog.emplace_back(Product{ std::format("Product {}", i), std::round(prices[i] * 100) / 100, false });
+		std::ranges::sort(catalog, {}, &Product::Price);
+
+		//Alternating operations: set a new price, then ask for the total of a range of ranks
+		auto const positions{ Bench::RandomVector<std::size_t>(operationCount, 0, count - 1, 2) };
+		auto const newPrices{ Bench::RandomVector<double>(operationCount, 1.0, 1000.0, 3) };
+		auto const spans{ Bench::RandomVector<std::size_t>(operationCount, 1, 4000, 4) };
+		auto const range = [&](std::size_t const i) { return std::pair{ positions[i] / 2, std::min(count, positions[i] / 2 + spans[i]) }; };
+
+		RangeQueries::FenwickTree<double> fenwick;
+		RangeQueries::SegmentTree<double> segments;
+		auto const buildFenwick{ Bench::Measure([&] { fenwick = { catalog, &Product::Price }; }, 3) };
+		auto const buildSegments{ Bench::Measure([&] { segments = { catalog, &Product::Price }; }, 3) };
+
+		std::vector<double> plain;
+		std::vector<double> expected(operationCount);
+		auto const accumulate{ Bench::Measure([&] { plain.clear(); std::ranges::transform(catalog, std::back_inserter(plain), &Product::Price); }, [&] {
+			for (std::size_t i = 0; i < operationCount; ++i)
+			{
+				plain[positions[i]] = newPrices[i];
+				auto const [first, last] { range(i) };
+				expected[i] = std::accumulate(plain.begin() + static_cast<std::ptrdiff_t>(first), plain.begin() + static_cast<std::ptrdiff_t>(last), 0.0);
+			}
+		}, 1) };
+		std::vector<double> sums(operationCount);
+		auto const close = [&] {
+			for (std::size_t i = 0; i < operationCount; ++i)
+				Bench::Check(std::abs(sums[i] - expected[i]) <= 1e-6 * std::max(1.0, expected[i]), "range sum matches the scan");
+		};
+		auto const fenwickOperations{ Bench::Measure([&] { fenwick = { catalog, &Product::Price }; }, [&] {
+			for (std::size_t i = 0; i < operationCount; ++i)
+			{
+				fenwick.Set(positions[i], newPrices[i]);
+				auto const [first, last] { range(i) };
+				sums[i] = fenwick.RangeSum(first, last);
+			}
+		}, 3) };
+		close();
+		auto const segmentOperations{ Bench::Measure([&] { segments = { catalog, &Product::Price }; }, [&] {
+			for (std::size_t i = 0; i < operationCount; ++i)
+			{
+				segments.Set(positions[i], newPrices[i]);
+				auto const [first, last] { range(i) };
+				sums[i] = segments.Query(first, last);
+			}
+		}, 3) };
+		close();
+
+		Bench::Report("Build FenwickTree", buildFenwick);
+		Bench::Report("Build SegmentTree", buildSegments);
+		Bench::Report("Vector + accumulate", accumulate);
+		Bench::Report("FenwickTree Set + RangeSum", fenwickOperations);
+		Bench::Report("SegmentTree Set + Query", segmentOperations);
+		Bench::ReportSpeedup("FenwickTree vs. accumulate", accumulate, fenwickOperations);
+		Bench::ReportSpeedup("SegmentTree vs. accumulate", accumulate, segmentOperations);
+
+		//A price update of a quarter of the catalog at once
+		std::vector<RangeQueries::PointUpdate<double>> updates(count / 4);
+		for (std::size_t i = 0; i < updates.size(); ++i)
+			updates[i] = { positions[i % operationCount] ^ i, newPrices[i % operationCount] };
+		auto const fenwickSingle{ Bench::Measure([&] { for (auto const& update : updates) fenwick.Set(update.Index, update.Value); }, 3) };
+		auto const fenwickBatch{ Bench::Measure([&] { fenwick.Set(updates); }, 3) };
+		auto const segmentSingle{ Bench::Measure([&] { for (auto const& update : updates) segments.Set(update.Index, update.Value); }, 3) };
+		auto const segmentBatch{ Bench::Measure([&] { segments.Set(updates); }, 3) };
+		Bench::Check(std::abs(fenwick.RangeSum(0, count) - segments.Query(0, count)) <= 1e-6 * segments.Query(0, count), "Fenwick and segment tree totals agree");
+		Bench::Report(std::format("FenwickTree, {} single updates", updates.size()), fenwickSingle);
+		Bench::Report("FenwickTree, batch update", fenwickBatch);
+		Bench::Report(std::format("SegmentTree, {} single updates", updates.size()), segmentSingle);
+		Bench::Report("SegmentTree, batch update", segmentBatch);
+		Bench::ReportSpeedup("FenwickTree batch vs. single", fenwickSingle, fenwickBatch);
+		Bench::ReportSpeedup("SegmentTree batch vs. single", segmentSingle, segmentBatch);
+	}
+
+	//"How many free-delivery items lie in rows [i, j)" and "where is the k-th free item": scans vs. a rank/select bitvector
+	void FreeDeliveryRankSelect()
+	{
+		ExerciseStart t{ "Benchmarks:FreeDeliveryRankSelect" };
+		std::size_t const count{ 1 << 22 };
+		std::size_t const queryCount{ 1 << 20 };
+		auto const draws{ Bench::RandomVector<int>(count, 0, 99, 1) };
+		std::vector<Product> catalog;
+		catalog.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			catalog.emplace_back(Product{ std::format("Product {}", i), 10.0, draws[i] < 30 });
+
+		Succinct::RankSelect freeDelivery;
+		auto const build{ Bench::Measure([&] { freeDelivery = { catalog, &Product::FreeDelivery }; }, 3) };
+		auto const firsts{ Bench::RandomVector<std::size_t>(queryCount, 0, count, 2) };
+		auto const lasts{ Bench::RandomVector<std::size_t>(queryCount, 0, count, 3) };
+		auto const ranks{ Bench::RandomVector<std::size_t>(queryCount, 0, freeDelivery.Count() - 1, 4) };
+
+		//The scans answer a small sample only
+		std::size_t const scanCount{ 200 };
+		std::vector<std::size_t> expected(scanCount);
+		auto const countScan{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < scanCount; ++q)
+			{
+				auto const [first, last] { std::minmax(firsts[q], lasts[q]) };
+				expected[q] = static_cast<std::size_t>(std::count_if(catalog.begin() + static_cast<std::ptrdiff_t>(first), catalog.begin() + static_cast<std::ptrdiff_t>(last), std::mem_fn(&Product::FreeDelivery)));
+			}
+		}, 1) };
+		for (std::size_t q = 0; q < scanCount; ++q)
+		{
+			auto const [first, last] { std::minmax(firsts[q], lasts[q]) };
+			Bench::Check(freeDelivery.Count(first, last) == expected[q], "RankSelect::Count matches std::count_if");
+		}
+		auto const selectScan{ Bench::Measure([&] {
+			for (std::size_t q = 0; q < scanCount; ++q)
+			{
+				std::size_t seen{ 0 };
+				auto const found{ std::find_if(catalog.begin(), catalog.end(), [&](Product const& product) { return product.FreeDelivery() and seen++ == ranks[q]; }) };
+				expected[q] = static_cast<std::size_t>(found - catalog.begin());
+			}
+		}, 1) };
+		for (std::size_t q = 0; q < scanCount; ++q)
+			Bench::Check(freeDelivery.Select1(ranks[q]) == expected[q], "RankSelect::Select1 matches the scan");
+
+		auto const countQueries{ Bench::Measure([&] {
+			std::size_t sum{ 0 };
+			for (std::size_t q = 0; q < queryCount; ++q)
+			{
+				auto const [first, last] { std::minmax(firsts[q], lasts[q]) };
+				sum += freeDelivery.Count(first, last);
+			}
+			Bench::DoNotOptimize(sum);
+		}, 3) };
+		auto const selectQueries{ Bench::Measure([&] {
+			std::size_t sum{ 0 };
+			for (auto const rank : ranks)
+				sum += freeDelivery.Select1(rank);
+			Bench::DoNotOptimize(sum);
+		}, 3) };
+
+		Bench::Report("Build from catalog", build);
+		Bench::Report(std::format("count_if scan, {} queries", scanCount), countScan);
+		Bench::Report(std::format("find_if scan, {} queries", scanCount), selectScan);
+		Bench::Report(std::format("Count (rank), {} queries", queryCount), countQueries);
+		Bench::Report(std::format("Select1, {} queries", queryCount), selectQueries);
+		Bench::ReportSpeedup("Rank vs. scan (per query)", countScan / scanCount, countQueries / queryCount);
+		Bench::ReportSpeedup("Select vs. scan (per query)", selectScan / scanCount, selectQueries / queryCount);
+		PrintF("  {:<40} {:>12.2f} %\n", "Directory + samples overhead", 100.0 * static_cast<double>(freeDelivery.OverheadBytes() * 8) / static_cast<double>(count));
+		Bench::ReportLatencies("Count latency", Bench::MeasureLatencies(queryCount, [&](std::size_t const q) {
+			auto const [first, last] { std::minmax(firsts[q], lasts[q]) };
+			Bench::DoNotOptimize(freeDelivery.Count(first, last));
+		}));
+		Bench::ReportLatencies("Select1 latency", Bench::MeasureLatencies(queryCount, [&](std::size_t const q) {
+			Bench::DoNotOptimize(freeDelivery.Select1(ranks[q]));
+		}));
+	}
+
+	//Partitions with a 50/50 random predicate: std::partition and std::stable_partition vs. the block-based kernels
+	void BlockPartition()
+	{
+		ExerciseStart t{ "Benchmarks:BlockPartition" };
+		auto const run = [](std::string_view const label, auto const& values, auto const pred, int const repetitions) {
+			auto work{ values };
+			auto const check = [&](auto const middle) {
+				Bench::Check(std::all_of(work.begin(), middle, pred) and std::none_of(middle, work.end(), pred), "partition splits at the returned position");
+			};
+			auto middle{ work.begin() };
+			auto const plain{ Bench::Measure([&] { work = values; }, [&] { middle = std::partition(work.begin(), work.end(), pred); }, repetitions) };
+			check(middle);
+			auto const block{ Bench::Measure([&] { work = values; }, [&] { middle = FastPath::Partition(work, pred); }, repetitions) };
+			check(middle);
+			auto const stable{ Bench::Measure([&] { work = values; }, [&] { middle = std::stable_partition(work.begin(), work.end(), pred); }, repetitions) };
+			auto const expected{ work };
+			auto const blockStable{ Bench::Measure([&] { work = values; }, [&] { middle = FastPath::StablePartition(work, pred); }, repetitions) };
+			check(middle);
+			Bench::Check(work == expected, "StablePartition matches std::stable_partition");
+
+			Bench::Report(std::format("{}: std::partition", label), plain);
+			Bench::Report(std::format("{}: FastPath::Partition", label), block);
+			Bench::Report(std::format("{}: std::stable_partition", label), stable);
+			Bench::Report(std::format("{}: FastPath::StablePartition", label), blockStable);
+			Bench::ReportSpeedup(std::format("{}: Partition speedup", label), plain, block);
+			Bench::ReportSpeedup(std::format("{}: StablePartition speedup", label), stable, blockStable);
+		};
+
+		//Parity of random numbers (ContainerAlgorithm::Exercise14)
+		run("int parity", Bench::RandomVector<int>(1 << 24, 0, 1'000'000, 1), [](int const value) { return value % 2 == 0; }, 3);
+
+		//Products by free delivery (ContainerAlgorithm::Exercise13)
+		std::size_t const count{ 1 << 20 };
+		auto const draws{ Bench::RandomVector<int>(count, 0, 1, 2) };
+		std::vector<Product> products;
+		products.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			products.emplace_back(Product{ std::format("Product {}", i), static_cast<double>(i % 1000), draws[i] == 1 });
+		run("Product", products, [](Product const& product) { return product.FreeDelivery(); }, 3);
+	}
+}
+
+int main(int argc, char* argv[])
 {
+	if (argc > 1 and std::string_view{ argv[1] } == "--bench")
+	{
+		//Benchmarks (run with --bench [name])
+		using namespace Benchmarks;
+		std::string_view const filter{ argc > 2 ? argv[2] : "" };
+		auto const run = [filter](std::string_view const name, void (*benchmark)()) {
+			if (filter.empty() or name == filter)
+				benchmark();
+		};
+		run("FastPaths", FastPaths);
+		run("NumaFirstTouch", NumaFirstTouch);
+		run("HugePages", HugePages);
+		run("SmallVectorAllocations", SmallVectorAllocations);
+		run("SelectionBitmap", SelectionBitmap);
+		run("PrefixSum", PrefixSum);
+		run("SmallDomainSort", SmallDomainSort);
+		run("Deduplication", Deduplication);
+		run("StreamingSketches", StreamingSketches);
+		run("PriceQuantiles", PriceQuantiles);
+		run("ExternalProductSort", ExternalProductSort);
+		run("ExternalSetOperations", ExternalSetOperations);
+		run("SearchIndexPersistence", SearchIndexPersistence);
+		run("LsmIngest", LsmIngest);
+		run("ProductLookup", ProductLookup);
+		run("TypeAhead", TypeAhead);
+		run("SubstringSearch", SubstringSearch);
+		run("NearDuplicateNames", NearDuplicateNames);
+		run("SortProductsByKey", SortProductsByKey);
+		run("PermutationApply", PermutationApply);
+		run("ShardSearch", ShardSearch);
+		run("RangeMaximum", RangeMaximum);
+		run("PriceRangeSums", PriceRangeSums);
+		run("FreeDeliveryRankSelect", FreeDeliveryRankSelect);
+		run("BlockPartition", BlockPartition);
+		if (Bench::FailedChecks() > 0)
+		{
+			PrintF("{} checks failed\n", Bench::FailedChecks());
+			return 1;
+		}
+		return 0;
+	}
+
 	{ 
 		// Some testing stuff
 		std::vector<int> vec = { 1 , 2, 3};
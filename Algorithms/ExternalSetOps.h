@@ -0,0 +1,254 @@
+#pragma once
+
+#include "pch.h"
+#include "ExternalSort.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
+//Streaming set difference, intersection and union over sorted on-disk files of integers (Exercise8's v1 \ v2 at scale).
+//Memory is bounded by three blocks (two inputs, one output); the inputs are read in large sequential blocks.
+//The semantics are those of std::set_difference / std::set_intersection / std::set_union.
+
+namespace External
+{
+	enum class SetOperation
+	{
+		Difference,		//a \ b
+		Intersection,	//a & b
+		Union			//a | b
+	};
+
+	struct SetOperationOptions
+	{
+		std::size_t BlockSize{ std::size_t{ 4 } << 20 };	//bytes per input/output block
+		bool SortInputs{ false };							//sort the inputs externally first
+		SortOptions Sort{};									//budgets for sorting the inputs
+	};
+
+	namespace Detail
+	{
+		//Sequential block reader of a raw file of T
+		template<typename T>
+		class BlockReader
+		{
+		public:
+			BlockReader(std::filesystem::path const& path, std::size_t const blockBytes)
+				: _Path{ path }, _File{ path, "rb", 0 }, _Block(std::max<std::size_t>(blockBytes / sizeof(T), 64))
+			{
+#if defined(__linux__)
+				::posix_fadvise(::fileno(_File.Get()), 0, 0, POSIX_FADV_SEQUENTIAL); //ask the kernel for aggressive readahead
+#endif
+			}
+
+			//Make sure there is unread data in the block; false at the end of the file, throws on a read error
+			bool Fill()
+			{
+				if (_Position == _Size)
+				{
+					_Size = std::fread(_Block.data(), sizeof(T), _Block.size(), _File.Get());
+					_Position = 0;
+					if (_Size < _Block.size() and std::ferror(_File.Get()) != 0)
+						throw std::runtime_error{ std::format("External: cannot read {}", _Path.string()) };
+				}
+				return _Position < _Size;
+			}
+
+			std::span<T const> Available() const noexcept
+			{
+				return { _Block.data() + _Position, _Size - _Position };
+			}
+
+			void Consume(std::size_t const count) noexcept
+			{
+				_Position += count;
+			}
+
+		private:
+			std::filesystem::path _Path;
+			File _File;
+			std::vector<T> _Block;
+			std::size_t _Position{ 0 };
+			std::size_t _Size{ 0 };
+		};
+
+		//Block writer of a raw file of T
+		template<typename T>
+		class BlockWriter
+		{
+		public:
+			BlockWriter(std::filesystem::path const& path, std::size_t const blockBytes)
+				: _Path{ path }, _File{ path, "wb", 0 }, _Block(std::max<std::size_t>(blockBytes / sizeof(T), 64)) {}
+
+			void Write(std::span<T const> values)
+			{
+				while (not values.empty())
+				{
+					std::size_t const step{ std::min(values.size(), _Block.size() - _Size) };
+					std::copy_n(values.begin(), step, _Block.begin() + _Size);
+					_Size += step;
+					_Written += step;
+					values = values.subspan(step);
+					if (_Size == _Block.size())
+						Flush();
+				}
+			}
+
+			void Write(T const& value)
+			{
+				Write(std::span<T const>{ &value, 1 });
+			}
+
+			//Write the last block and close the file; returns the number of values written
+			std::size_t Close()
+			{
+				Flush();
+				_File.Close(_Path);
+				return _Written;
+			}
+
+		private:
+			void Flush()
+			{
+				if (std::fwrite(_Block.data(), sizeof(T), _Size, _File.Get()) != _Size)
+					throw std::runtime_error{ std::format("External: cannot write {}", _Path.string()) };
+				_Size = 0;
+			}
+
+			std::filesystem::path _Path;
+			File _File;
+			std::vector<T> _Block;
+			std::size_t _Size{ 0 };
+			std::size_t _Written{ 0 };
+		};
+
+		//Length of the prefix of values that is smaller than limit (values sorted), looking at most 8 values ahead.
+		//int32 compares the 8 values with one AVX2 instruction.
+		template<typename T>
+		std::size_t CountLess(std::span<T const> const values, T const limit) noexcept
+		{
+#if defined(__AVX2__)
+			if constexpr (std::same_as<T, std::int32_t> or (std::same_as<T, int> and sizeof(int) == 4))
+			{
+				if (values.size() >= 8)
+				{
+					__m256i const block{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(values.data())) };
+					__m256i const less{ _mm256_cmpgt_epi32(_mm256_set1_epi32(limit), block) };
+					return static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(less)))));
+				}
+			}
+#endif
+			std::size_t count{ 0 };
+			std::size_t const lookahead{ std::min<std::size_t>(values.size(), 8) };
+			while (count < lookahead and values[count] < limit)
+				++count;
+			return count;
+		}
+	}
+
+	//Write a span of values to a raw binary file
+	template<typename T>
+	void WriteFile(std::filesystem::path const& path, std::span<T const> const values)
+	{
+		Detail::BlockWriter<T> writer{ path, std::size_t{ 1 } << 20 };
+		writer.Write(values);
+		writer.Close();
+	}
+
+	//Read a raw binary file of T into memory
+	template<typename T>
+	std::vector<T> ReadFile(std::filesystem::path const& path)
+	{
+		std::vector<T> values(std::filesystem::file_size(path) / sizeof(T));
+		Detail::File file{ path, "rb", 0 };
+		if (std::fread(values.data(), sizeof(T), values.size(), file.Get()) != values.size())
+			throw std::runtime_error{ std::format("External: cannot read {}", path.string()) };
+		return values;
+	}
+
+	//Sort a raw binary file of T into another file with the external merge sort
+	template<typename T>
+	void SortFile(std::filesystem::path const& input, std::filesystem::path const& output, SortOptions const& options = {})
+	{
+		ExternalSorter<T> sorter{ options };
+		Detail::BlockReader<T> reader{ input, options.IoBufferSize };
+		while (reader.Fill())
+		{
+			sorter.AddRange(reader.Available());
+			reader.Consume(reader.Available().size());
+		}
+		Detail::BlockWriter<T> writer{ output, options.IoBufferSize };
+		sorter.Finish([&writer](T const& value) { writer.Write(value); });
+		writer.Close();
+	}
+
+	//Apply a set operation to the sorted files a and b and write the sorted result to output.
+	//Returns the number of values written.
+	template<std::integral T>
+	std::size_t ApplySetOperation(std::filesystem::path const& a, std::filesystem::path const& b, std::filesystem::path const& output,
+		SetOperation const operation, SetOperationOptions const& options = {})
+	{
+		if (options.SortInputs)
+		{
+			//Sort both inputs to temporary files first; they are removed on every path out of this scope
+			Detail::TemporaryFile const sortedA{ options.Sort.TempDirectory / (output.filename().string() + ".a.sorted") };
+			Detail::TemporaryFile const sortedB{ options.Sort.TempDirectory / (output.filename().string() + ".b.sorted") };
+			SortFile<T>(a, sortedA.Path(), options.Sort);
+			SortFile<T>(b, sortedB.Path(), options.Sort);
+			SetOperationOptions sortedOptions{ options };
+			sortedOptions.SortInputs = false;
+			return ApplySetOperation<T>(sortedA.Path(), sortedB.Path(), output, operation, sortedOptions);
+		}
+
+		bool const emitOnlyA{ operation != SetOperation::Intersection };
+		bool const emitOnlyB{ operation == SetOperation::Union };
+		bool const emitBoth{ operation != SetOperation::Difference };
+		Detail::BlockReader<T> readerA{ a, options.BlockSize };
+		Detail::BlockReader<T> readerB{ b, options.BlockSize };
+		Detail::BlockWriter<T> writer{ output, options.BlockSize };
+
+		while (readerA.Fill() and readerB.Fill())
+		{
+			auto const valuesA{ readerA.Available() };
+			auto const valuesB{ readerB.Available() };
+			std::size_t i{ 0 };
+			std::size_t j{ 0 };
+			while (i < valuesA.size() and j < valuesB.size())
+			{
+				//Runs of up to 8 values from one side that are below the other side's head move in one step
+				if (std::size_t const run{ Detail::CountLess(valuesA.subspan(i), valuesB[j]) }; run > 0)
+				{
+					if (emitOnlyA)
+						writer.Write(valuesA.subspan(i, run));
+					i += run;
+				}
+				else if (std::size_t const runB{ Detail::CountLess(valuesB.subspan(j), valuesA[i]) }; runB > 0)
+				{
+					if (emitOnlyB)
+						writer.Write(valuesB.subspan(j, runB));
+					j += runB;
+				}
+				else
+				{
+					//Equal heads
+					if (emitBoth)
+						writer.Write(valuesA[i]);
+					++i;
+					++j;
+				}
+			}
+			readerA.Consume(i);
+			readerB.Consume(j);
+		}
+
+		//One input is exhausted: the rest of the other one is copied (a for difference and union, b for union)
+		if (emitOnlyA)
+			for (; readerA.Fill(); readerA.Consume(readerA.Available().size()))
+				writer.Write(readerA.Available());
+		if (emitOnlyB)
+			for (; readerB.Fill(); readerB.Consume(readerB.Available().size()))
+				writer.Write(readerB.Available());
+		return writer.Close();
+	}
+}
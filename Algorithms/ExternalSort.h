@@ -0,0 +1,351 @@
+#pragma once
+
+#include "pch.h"
+#include "LoserTree.h"
+#include "FastAlgorithms.h"
+
+//External merge sort for data sets larger than RAM: sorted runs are spilled to local disk in a compact binary format
+//and merged with a loser tree. Run generation overlaps with I/O: one buffer is filled while the previous one is
+//sorted and written by a worker thread.
+
+namespace External
+{
+	//Binary encoding of one record in a run file; specialize it for your own types (see Product in Exercises.cpp)
+	template<typename T>
+	struct RecordTraits;
+
+	//Trivially copyable types are written as raw bytes
+	template<typename T>
+		requires std::is_trivially_copyable_v<T>
+	struct RecordTraits<T>
+	{
+		static void Write(std::FILE* file, T const& value)
+		{
+			std::fwrite(&value, sizeof(T), 1, file);
+		}
+		static bool Read(std::FILE* file, T& value)
+		{
+			return std::fread(&value, sizeof(T), 1, file) == 1;
+		}
+		static std::size_t Size(T const&) noexcept
+		{
+			return sizeof(T);
+		}
+	};
+
+	template<typename T>
+	concept Record = requires(std::FILE* file, T const& in, T& out)
+	{
+		RecordTraits<T>::Write(file, in);
+		{ RecordTraits<T>::Read(file, out) } -> std::same_as<bool>;
+		{ RecordTraits<T>::Size(in) } -> std::convertible_to<std::size_t>; //bytes the value occupies in memory
+	};
+
+	//Length-prefixed strings, for RecordTraits specializations
+	inline void WriteString(std::FILE* file, std::string_view const text)
+	{
+		auto const length{ static_cast<std::uint32_t>(text.size()) };
+		std::fwrite(&length, sizeof(length), 1, file);
+		std::fwrite(text.data(), 1, text.size(), file);
+	}
+
+	inline bool ReadString(std::FILE* file, std::string& text)
+	{
+		std::uint32_t length{ 0 };
+		if (std::fread(&length, sizeof(length), 1, file) != 1)
+			return false;
+		text.resize(length);
+		return std::fread(text.data(), 1, length, file) == length;
+	}
+
+	struct SortOptions
+	{
+		std::size_t MemoryBudget{ std::size_t{ 256 } << 20 };	//bytes for the in-memory buffers (both halves together)
+		std::size_t MaxOpenFiles{ 64 };							//maximum number of runs merged at once
+		std::size_t IoBufferSize{ std::size_t{ 1 } << 20 };		//stdio buffer per open run file
+		std::filesystem::path TempDirectory{ std::filesystem::temp_directory_path() };
+	};
+
+	namespace Detail
+	{
+		//Owning FILE* with a large stdio buffer (bufferSize 0: the default buffer, for callers that read and write whole blocks)
+		class File
+		{
+		public:
+			File(std::filesystem::path const& path, char const* mode, std::size_t const bufferSize) : _Buffer(bufferSize)
+			{
+				_File = std::fopen(path.string().c_str(), mode);
+				if (_File == nullptr)
+					throw std::runtime_error{ std::format("External: cannot open {}", path.string()) };
+				if (not _Buffer.empty())
+					std::setvbuf(_File, _Buffer.data(), _IOFBF, _Buffer.size());
+			}
+			~File()
+			{
+				if (_File != nullptr)
+					std::fclose(_File);
+			}
+			File(File&& other) noexcept : _File{ std::exchange(other._File, nullptr) }, _Buffer{ std::move(other._Buffer) } {}
+			File(File const&) = delete;
+			File& operator=(File const&) = delete;
+
+			std::FILE* Get() const noexcept { return _File; }
+
+			//Flush and report write errors (e.g. a full disk)
+			void Close(std::filesystem::path const& path)
+			{
+				bool const failed{ std::ferror(_File) != 0 or std::fclose(_File) != 0 };
+				_File = nullptr;
+				if (failed)
+					throw std::runtime_error{ std::format("External: cannot write {}", path.string()) };
+			}
+
+		private:
+			std::FILE* _File{ nullptr };
+			std::vector<char> _Buffer;
+		};
+
+		//Removes a temporary file when it goes out of scope, also when an exception is thrown, unless it was released
+		class TemporaryFile
+		{
+		public:
+			explicit TemporaryFile(std::filesystem::path path) : _Path{ std::move(path) } {}
+			~TemporaryFile()
+			{
+				if (not _Path.empty())
+				{
+					std::error_code error;
+					std::filesystem::remove(_Path, error);
+				}
+			}
+			TemporaryFile(TemporaryFile&& other) noexcept : _Path{ std::exchange(other._Path, {}) } {}
+			TemporaryFile(TemporaryFile const&) = delete;
+			TemporaryFile& operator=(TemporaryFile const&) = delete;
+
+			std::filesystem::path const& Path() const noexcept { return _Path; }
+
+			//Keep the file: the caller takes over its removal
+			std::filesystem::path Release() noexcept { return std::exchange(_Path, {}); }
+
+		private:
+			std::filesystem::path _Path;
+		};
+
+		//Sequential reader of one run file. Trivially copyable records are read a block at a time.
+		//A read error throws; only the end of the file ends the run.
+		template<Record T>
+		class RunReader
+		{
+		public:
+			RunReader(std::filesystem::path const& path, std::size_t const bufferSize)
+				: _Path{ path }, _File{ path, "rb", std::is_trivially_copyable_v<T> ? 0 : bufferSize }, _Block(std::is_trivially_copyable_v<T> ? std::max<std::size_t>(bufferSize / sizeof(T), 1) : 0)
+			{
+			}
+
+			std::optional<T> Next()
+			{
+				if constexpr (std::is_trivially_copyable_v<T>)
+				{
+					if (_Position == _Size)
+					{
+						_Size = std::fread(_Block.data(), sizeof(T), _Block.size(), _File.Get());
+						_Position = 0;
+						if (_Size < _Block.size())
+							CheckReadError();
+						if (_Size == 0)
+							return std::nullopt;
+					}
+					return _Block[_Position++];
+				}
+				else
+				{
+					T value{};
+					if (not RecordTraits<T>::Read(_File.Get(), value))
+					{
+						CheckReadError();
+						return std::nullopt;
+					}
+					return value;
+				}
+			}
+
+		private:
+			void CheckReadError() const
+			{
+				if (std::ferror(_File.Get()) != 0)
+					throw std::runtime_error{ std::format("External: cannot read {}", _Path.string()) };
+			}
+
+			std::filesystem::path _Path;
+			File _File;
+			std::vector<T> _Block;
+			std::size_t _Position{ 0 };
+			std::size_t _Size{ 0 };
+		};
+	}
+
+	template<Record T, typename Compare = std::less<>>
+	class ExternalSorter
+	{
+	public:
+		explicit ExternalSorter(SortOptions options = {}, Compare compare = {}) : _Options{ std::move(options) }, _Compare{ std::move(compare) }
+		{
+			_Options.MaxOpenFiles = std::max<std::size_t>(_Options.MaxOpenFiles, 3);
+			_RunPrefix = std::format("learnstl-{:x}-{:x}", std::random_device{}(), reinterpret_cast<std::uintptr_t>(this));
+		}
+
+		~ExternalSorter()
+		{
+			std::error_code error;
+			if (_PendingSpill.valid())
+			{
+				//The run of a spill still in flight is not in _Runs yet
+				try
+				{
+					std::filesystem::remove(_PendingSpill.get(), error);
+				}
+				catch (...)
+				{
+				}
+			}
+			for (auto const& run : _Runs)
+				std::filesystem::remove(run, error);
+		}
+
+		ExternalSorter(ExternalSorter const&) = delete;
+		ExternalSorter& operator=(ExternalSorter const&) = delete;
+
+		void Add(T value)
+		{
+			_BufferBytes += RecordTraits<T>::Size(value);
+			_Buffer.push_back(std::move(value));
+			if (_BufferBytes >= _Options.MemoryBudget / 2)
+				Spill();
+		}
+
+		template<std::ranges::input_range R>
+		void AddRange(R const& range)
+		{
+			for (auto const& value : range)
+				Add(value);
+		}
+
+		//Number of runs spilled to disk so far
+		std::size_t RunCount() const noexcept
+		{
+			return _Runs.size() + (_PendingSpill.valid() ? 1 : 0);
+		}
+
+		//Merge everything added so far and call consume(value) for each value in sorted order
+		template<typename Consumer>
+		void Finish(Consumer&& consume)
+		{
+			if (_Runs.empty() and not _PendingSpill.valid())
+			{
+				//Everything fit in memory
+				std::sort(_Buffer.begin(), _Buffer.end(), _Compare);
+				for (auto const& value : _Buffer)
+					consume(value);
+				_Buffer.clear();
+				_BufferBytes = 0;
+				return;
+			}
+			if (not _Buffer.empty())
+				Spill();
+			WaitForSpill();
+
+			//Fan-in is limited by the file budget and by the memory for the read buffers
+			std::size_t const fanIn{ std::clamp<std::size_t>(_Options.MemoryBudget / _Options.IoBufferSize, 2, _Options.MaxOpenFiles - 1) };
+			while (_Runs.size() > fanIn)
+			{
+				//Intermediate pass: merge groups of fanIn runs into longer runs.
+				//The new runs are removed if the pass fails, until they replace the old ones in _Runs.
+				std::vector<Detail::TemporaryFile> merged;
+				for (std::size_t first = 0; first < _Runs.size(); first += fanIn)
+				{
+					std::span<std::filesystem::path const> const group{ _Runs.data() + first, std::min(fanIn, _Runs.size() - first) };
+					auto const& path{ merged.emplace_back(NextRunPath()).Path() };
+					Detail::File file{ path, "wb", _Options.IoBufferSize };
+					Merge(group, [&file](T const& value) { RecordTraits<T>::Write(file.Get(), value); });
+					file.Close(path);
+				}
+				RemoveRuns();
+				_Runs.reserve(merged.size());
+				for (auto& run : merged)
+					_Runs.push_back(run.Release());
+			}
+			Merge(_Runs, consume);
+			RemoveRuns();
+		}
+
+	private:
+		std::filesystem::path NextRunPath()
+		{
+			return _Options.TempDirectory / std::format("{}-{}.run", _RunPrefix, _NextRunId++);
+		}
+
+		//Hand the full buffer to a worker thread that sorts and writes it, and continue with an empty buffer
+		void Spill()
+		{
+			WaitForSpill(); //at most one buffer in flight, so memory stays within the budget
+			_PendingSpill = std::async(std::launch::async, [this, values = std::move(_Buffer), path = NextRunPath()]() mutable {
+				if constexpr (Traits::ArithmeticKey<T> and (std::same_as<Compare, std::less<>> or std::same_as<Compare, std::less<T>>))
+					FastPath::Sort(values);
+				else
+					std::sort(values.begin(), values.end(), _Compare);
+				Detail::File file{ path, "wb", _Options.IoBufferSize };
+				if constexpr (std::is_trivially_copyable_v<T>)
+					std::fwrite(values.data(), sizeof(T), values.size(), file.Get()); //same bytes as RecordTraits, in one call
+				else
+					for (auto const& value : values)
+						RecordTraits<T>::Write(file.Get(), value);
+				file.Close(path);
+				return path;
+			});
+			_Buffer = {};
+			_BufferBytes = 0;
+		}
+
+		void WaitForSpill()
+		{
+			if (_PendingSpill.valid())
+				_Runs.push_back(_PendingSpill.get());
+		}
+
+		template<typename Consumer>
+		void Merge(std::span<std::filesystem::path const> const runs, Consumer&& consume)
+		{
+			std::vector<Detail::RunReader<T>> readers;
+			std::vector<std::optional<T>> heads;
+			readers.reserve(runs.size());
+			for (auto const& run : runs)
+			{
+				readers.emplace_back(run, _Options.IoBufferSize);
+				heads.push_back(readers.back().Next());
+			}
+			Merging::LoserTree<T, Compare> tree{ std::move(heads), _Compare };
+			while (not tree.Empty())
+			{
+				consume(tree.Top());
+				tree.ReplaceTop(readers[tree.TopSource()].Next());
+			}
+		}
+
+		void RemoveRuns()
+		{
+			std::error_code error;
+			for (auto const& run : _Runs)
+				std::filesystem::remove(run, error);
+			_Runs.clear();
+		}
+
+		SortOptions _Options;
+		Compare _Compare;
+		std::string _RunPrefix;
+		std::size_t _NextRunId{ 0 };
+		std::vector<T> _Buffer;
+		std::size_t _BufferBytes{ 0 };
+		std::future<std::filesystem::path> _PendingSpill;
+		std::vector<std::filesystem::path> _Runs;
+	};
+}
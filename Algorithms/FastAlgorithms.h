@@ -0,0 +1,208 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+
+//Copy, move, reverse, search and sort utilities that pick a fast path at compile time.
+//Each function falls back to the generic STL algorithm if its fast path does not apply.
+
+namespace FastPath
+{
+	//Both iterators are contiguous and point to the same trivially copyable type
+	template<typename InIt, typename OutIt>
+	concept MemCopyable = Traits::ContiguousIterator<InIt> and Traits::ContiguousIterator<OutIt>
+		and std::same_as<std::iter_value_t<InIt>, std::iter_value_t<OutIt>>
+		and Traits::TriviallyCopyable<std::iter_value_t<InIt>>;
+
+	//Copy [first, last) to dest
+	template<std::input_iterator InIt, typename OutIt>
+	OutIt Copy(InIt first, InIt last, OutIt dest)
+	{
+		if constexpr (MemCopyable<InIt, OutIt>)
+		{
+			auto const count{ last - first };
+			if (count > 0)
+				std::memmove(std::to_address(dest), std::to_address(first), count * sizeof(std::iter_value_t<InIt>));
+			return dest + count;
+		}
+		else
+		{
+			return std::copy(first, last, dest);
+		}
+	}
+
+	//Append all elements of range to the end of v (the fast version of copy with back_inserter)
+	template<typename T, std::ranges::input_range R>
+	void Append(std::vector<T>& v, R const& range)
+	{
+		if constexpr (Traits::ContiguousRange<R> and std::same_as<std::ranges::range_value_t<R>, T> and Traits::TriviallyCopyable<T>)
+		{
+			auto const oldSize{ v.size() };
+			v.resize(oldSize + std::ranges::size(range));
+			Copy(std::ranges::begin(range), std::ranges::end(range), v.begin() + oldSize);
+		}
+		else
+		{
+			v.insert(v.end(), std::ranges::begin(range), std::ranges::end(range));
+		}
+	}
+
+	//Move [first, last) to dest
+	template<std::input_iterator InIt, typename OutIt>
+	OutIt Move(InIt first, InIt last, OutIt dest)
+	{
+		if constexpr (MemCopyable<InIt, OutIt>)
+			return Copy(first, last, dest); //moving a trivially copyable object is a copy
+		else
+			return std::move(first, last, dest);
+	}
+
+	//Move-construct [first, last) into the uninitialized memory at dest and destroy the source objects
+	template<typename T>
+	T* Relocate(T* first, T* last, T* dest) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if constexpr (Traits::TriviallyRelocatable<T>)
+		{
+			auto const count{ last - first };
+			if (count > 0)
+				std::memmove(static_cast<void*>(dest), static_cast<void const*>(first), count * sizeof(T));
+			return dest + count;
+		}
+		else
+		{
+			T* end{ std::uninitialized_move(first, last, dest) };
+			std::destroy(first, last);
+			return end;
+		}
+	}
+
+	//Reverse the elements in [first, last)
+	template<std::bidirectional_iterator It>
+	void Reverse(It first, It last)
+	{
+#if defined(__AVX2__)
+		using T = std::iter_value_t<It>;
+		if constexpr (Traits::ContiguousIterator<It> and Traits::TriviallyCopyable<T> and (sizeof(T) == 4 or sizeof(T) == 8))
+		{
+			//Swap 32 byte blocks from both ends and reverse the lanes inside each block
+			constexpr std::ptrdiff_t Lanes{ 32 / sizeof(T) };
+			auto const reverseLanes = [](__m256i block) {
+				if constexpr (sizeof(T) == 4)
+					return _mm256_permutevar8x32_epi32(block, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+				else
+					return _mm256_permute4x64_epi64(block, 0x1B);
+			};
+			T* low{ std::to_address(first) };
+			T* high{ low + (last - first) };
+			while (high - low >= 2 * Lanes)
+			{
+				high -= Lanes;
+				__m256i const a{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(low)) };
+				__m256i const b{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(high)) };
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(low), reverseLanes(b));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(high), reverseLanes(a));
+				low += Lanes;
+			}
+			std::reverse(low, high);
+			return;
+		}
+#endif
+		std::reverse(first, last);
+	}
+
+	template<std::ranges::bidirectional_range R>
+	void Reverse(R&& range)
+	{
+		Reverse(std::ranges::begin(range), std::ranges::end(range));
+	}
+
+	//Return the first element in the sorted range [first, last) that is >= value, or last (same as std::lower_bound)
+	template<std::forward_iterator It, typename ValueType>
+	It LowerBound(It first, It last, ValueType const& value)
+	{
+		using T = std::iter_value_t<It>;
+		//Only for a value of the element type: converting 2.5 to int would change the answer
+		if constexpr (Traits::ContiguousIterator<It> and Traits::ArithmeticKey<T> and std::same_as<ValueType, T>)
+		{
+			//Branch-free binary search: the comparison only selects the next base, so there is nothing to mispredict
+			auto length{ static_cast<std::size_t>(last - first) };
+			if (length == 0)
+				return last;
+			T const key{ value };
+			T const* base{ std::to_address(first) };
+			while (length > 1)
+			{
+				std::size_t const half{ length / 2 };
+				base = (base[half] < key) ? base + half : base;
+				length -= half;
+			}
+			base += (*base < key);
+			return first + (base - std::to_address(first));
+		}
+		else
+		{
+			return std::lower_bound(first, last, value);
+		}
+	}
+
+	//Below this size the radix sort setup costs more than it saves
+	inline constexpr std::size_t RadixSortThreshold{ 512 };
+
+	//LSD radix sort with 8 bit digits on the ordered bit patterns of the keys
+	template<Traits::ArithmeticKey T>
+	void RadixSort(T* data, std::size_t count)
+	{
+		using U = Traits::UnsignedKey<T>;
+		constexpr std::size_t Passes{ sizeof(T) };
+		if (count == 0)
+			return;
+
+		std::vector<U> keys(count);
+		std::vector<U> buffer(count);
+		std::array<std::array<std::size_t, 256>, Passes> histograms{};
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			keys[i] = Traits::ToOrderedBits(data[i]);
+			for (std::size_t pass = 0; pass < Passes; ++pass)
+				++histograms[pass][(keys[i] >> (pass * 8)) & 0xFF];
+		}
+
+		U* source{ keys.data() };
+		U* target{ buffer.data() };
+		for (std::size_t pass = 0; pass < Passes; ++pass)
+		{
+			auto& histogram{ histograms[pass] };
+			if (histogram[(source[0] >> (pass * 8)) & 0xFF] == count)
+				continue; //all keys share this digit
+			std::exclusive_scan(histogram.begin(), histogram.end(), histogram.begin(), std::size_t{ 0 });
+			for (std::size_t i = 0; i < count; ++i)
+				target[histogram[(source[i] >> (pass * 8)) & 0xFF]++] = source[i];
+			std::swap(source, target);
+		}
+
+		std::transform(source, source + count, data, Traits::FromOrderedBits<T>);
+	}
+
+	//Sort [first, last) ascending
+	template<std::random_access_iterator It>
+	void Sort(It first, It last)
+	{
+		using T = std::iter_value_t<It>;
+		if constexpr (Traits::ContiguousIterator<It> and Traits::ArithmeticKey<T>)
+		{
+			auto const count{ static_cast<std::size_t>(last - first) };
+			if (count >= RadixSortThreshold)
+			{
+				RadixSort(std::to_address(first), count);
+				return;
+			}
+		}
+		std::sort(first, last);
+	}
+
+	template<std::ranges::random_access_range R>
+	void Sort(R&& range)
+	{
+		Sort(std::ranges::begin(range), std::ranges::end(range));
+	}
+}
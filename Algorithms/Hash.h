@@ -0,0 +1,63 @@
+#pragma once
+
+#include "pch.h"
+
+//Fast 64 bit hashing for integers and strings, used by the sketches, filters and hash tables
+
+namespace Hashing
+{
+	//Finalizer of SplitMix64: every input bit affects every output bit
+	constexpr std::uint64_t Mix64(std::uint64_t x) noexcept
+	{
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBull;
+		x ^= x >> 31;
+		return x;
+	}
+
+	//Hash of a byte string: 8 bytes per step, each word mixed into the state
+	inline std::uint64_t HashBytes(std::string_view const bytes, std::uint64_t const seed = 0) noexcept
+	{
+		std::uint64_t state{ seed ^ (bytes.size() * 0x9E3779B97F4A7C15ull) };
+		std::size_t i{ 0 };
+		for (; i + 8 <= bytes.size(); i += 8)
+		{
+			std::uint64_t word;
+			std::memcpy(&word, bytes.data() + i, 8);
+			state = Mix64(state ^ word);
+		}
+		if (i < bytes.size())
+		{
+			std::uint64_t word{ 0 };
+			std::memcpy(&word, bytes.data() + i, bytes.size() - i);
+			state = Mix64(state ^ word);
+		}
+		return Mix64(state);
+	}
+
+	//Hash of an integer or a string
+	template<typename T>
+	std::uint64_t Hash(T const& value, std::uint64_t const seed = 0) noexcept
+	{
+		if constexpr (std::integral<T>)
+			return Mix64(static_cast<std::uint64_t>(value) ^ seed);
+		else if constexpr (std::convertible_to<T const&, std::string_view>)
+			return HashBytes(std::string_view{ value }, seed);
+		else
+			return Mix64(std::hash<T>{}(value) ^ seed);
+	}
+
+	//Transparent hash functor: std::string, std::string_view and char const* of the same text hash alike
+	struct Hasher
+	{
+		using is_transparent = void;
+
+		template<typename T>
+		std::uint64_t operator()(T const& value) const noexcept
+		{
+			return Hash(value);
+		}
+	};
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "pch.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+//Huge-page backed allocation for large containers: fewer TLB misses for sort/search kernels over multi-GB vectors.
+//Linux only: on other platforms all allocations come from the default heap.
+
+namespace Memory
+{
+	inline constexpr std::size_t HugePageSize{ std::size_t{ 2 } << 20 };
+
+#if defined(__linux__)
+	namespace Detail
+	{
+		inline std::size_t HugePageAlign(std::size_t const bytes) noexcept
+		{
+			return (bytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+		}
+
+		//Map bytes (a multiple of HugePageSize) at a huge page aligned address.
+		//Tries reserved huge pages (MAP_HUGETLB) first, then transparent huge pages (madvise), returns nullptr on failure.
+		inline void* MapHugePages(std::size_t const bytes) noexcept
+		{
+#if defined(MAP_HUGETLB)
+			void* memory{ ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0) };
+			if (memory != MAP_FAILED)
+				return memory;
+#endif
+			//No reserved huge pages: over-map, trim to an aligned window and ask for transparent huge pages
+			std::size_t const mappedBytes{ bytes + HugePageSize };
+			void* mapped{ ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+			if (mapped == MAP_FAILED)
+				return nullptr;
+			auto const begin{ reinterpret_cast<std::uintptr_t>(mapped) };
+			auto const aligned{ (begin + HugePageSize - 1) / HugePageSize * HugePageSize };
+			if (aligned > begin)
+				::munmap(mapped, aligned - begin);
+			if (std::size_t const tail{ begin + mappedBytes - (aligned + bytes) }; tail > 0)
+				::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+#if defined(MADV_HUGEPAGE)
+			::madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE); //only a hint, failure is harmless
+#endif
+			return reinterpret_cast<void*>(aligned);
+		}
+	}
+#endif
+
+	//Allocator that uses huge pages for allocations of at least Threshold bytes and the normal heap below that
+	template<typename T, std::size_t Threshold = HugePageSize>
+	class HugePageAllocator
+	{
+	public:
+		using value_type = T;
+
+		template<typename U>
+		struct rebind
+		{
+			using other = HugePageAllocator<U, Threshold>;
+		};
+
+		HugePageAllocator() noexcept = default;
+		template<typename U>
+		HugePageAllocator(HugePageAllocator<U, Threshold> const&) noexcept {}
+
+		T* allocate(std::size_t const count)
+		{
+			if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+				throw std::bad_array_new_length{};
+#if defined(__linux__)
+			if (count * sizeof(T) >= Threshold)
+			{
+				if (void* memory{ Detail::MapHugePages(Detail::HugePageAlign(count * sizeof(T))) })
+					return static_cast<T*>(memory);
+				throw std::bad_alloc{};
+			}
+#endif
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ alignof(T) }));
+		}
+
+		void deallocate(T* pointer, std::size_t const count) noexcept
+		{
+#if defined(__linux__)
+			if (count * sizeof(T) >= Threshold)
+			{
+				::munmap(pointer, Detail::HugePageAlign(count * sizeof(T)));
+				return;
+			}
+#endif
+			::operator delete(pointer, std::align_val_t{ alignof(T) });
+		}
+
+		template<typename U>
+		bool operator==(HugePageAllocator<U, Threshold> const&) const noexcept
+		{
+			return true;
+		}
+	};
+
+	template<typename T>
+	using HugePageVector = std::vector<T, HugePageAllocator<T>>;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "pch.h"
+
+//Tournament tree of losers for k-way merging: picking the next smallest of k sorted sources takes log2(k) comparisons,
+//each against one stored loser on the path from the leaf to the root.
+
+namespace Merging
+{
+	template<typename T, typename Compare = std::less<>>
+	class LoserTree
+	{
+	public:
+		//One head per source; an empty head means the source is exhausted
+		explicit LoserTree(std::vector<std::optional<T>> heads, Compare compare = {})
+			: _Heads{ std::move(heads) }, _Losers(std::max<std::size_t>(_Heads.size(), 1)), _Compare{ std::move(compare) }
+		{
+			std::size_t const k{ _Heads.size() };
+			if (k == 0)
+				return;
+			//Build bottom up: leaf i is node k + i, the winner of each match moves up, the loser stays
+			std::vector<std::size_t> winners(2 * k);
+			for (std::size_t i = 0; i < k; ++i)
+				winners[k + i] = i;
+			for (std::size_t node = k - 1; node >= 1; --node)
+			{
+				std::size_t const left{ winners[2 * node] };
+				std::size_t const right{ winners[2 * node + 1] };
+				bool const leftWins{ Beats(left, right) };
+				winners[node] = leftWins ? left : right;
+				_Losers[node] = leftWins ? right : left;
+			}
+			_Losers[0] = k == 1 ? 0 : winners[1];
+		}
+
+		//True if all sources are exhausted
+		bool Empty() const noexcept
+		{
+			return _Heads.empty() or not _Heads[_Losers[0]].has_value();
+		}
+
+		//Source index of the smallest head
+		std::size_t TopSource() const noexcept
+		{
+			return _Losers[0];
+		}
+
+		T const& Top() const noexcept
+		{
+			return *_Heads[_Losers[0]];
+		}
+
+		//Replace the smallest head with the next value of its source (or nothing if the source is exhausted)
+		void ReplaceTop(std::optional<T> next)
+		{
+			std::size_t winner{ _Losers[0] };
+			_Heads[winner] = std::move(next);
+			for (std::size_t node = (_Heads.size() + winner) / 2; node >= 1; node /= 2)
+				if (Beats(_Losers[node], winner))
+					std::swap(_Losers[node], winner);
+			_Losers[0] = winner;
+		}
+
+	private:
+		//Source a beats source b if its head is smaller; ties go to the lower index, which keeps merges stable
+		bool Beats(std::size_t const a, std::size_t const b) const
+		{
+			if (not _Heads[a])
+				return false;
+			if (not _Heads[b])
+				return true;
+			if (_Compare(*_Heads[a], *_Heads[b]))
+				return true;
+			if (_Compare(*_Heads[b], *_Heads[a]))
+				return false;
+			return a < b;
+		}
+
+		std::vector<std::optional<T>> _Heads;
+		std::vector<std::size_t> _Losers; //_Losers[0] is the overall winner
+		Compare _Compare;
+	};
+}
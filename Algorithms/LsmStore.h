@@ -0,0 +1,332 @@
+#pragma once
+
+#include "pch.h"
+#include "Hash.h"
+#include "BloomFilter.h"
+#include "LoserTree.h"
+
+//Log-structured ordered store: writes go to a hash-based write buffer, full buffers become sorted immutable runs
+//and a worker thread compacts runs in the background. Deletes are tombstones until a compaction reaches the oldest run.
+//Reads look at the buffer and then at the runs from newest to oldest; each run has fence pointers (the first key
+//of every block) and a Bloom filter, so a point lookup skips most runs and searches a single block of the others.
+
+namespace Containers
+{
+	struct LsmOptions
+	{
+		std::size_t BufferCapacity{ 1 << 16 };	//entries in the write buffer before it becomes a run
+		std::size_t MaxRuns{ 8 };				//more runs start a compaction; at least 2
+		std::size_t CompactionFanout{ 2 };		//merge the next older run while it is at most this times the merged size
+		std::size_t FenceInterval{ 64 };		//entries per fence block; at least 1
+		double BloomBitsPerKey{ 10.0 };			//greater than 0
+		bool BackgroundCompaction{ true };		//false: compact on the writing thread
+	};
+
+	template<typename Key, typename Value, typename Compare = std::less<>>
+	class LsmStore
+	{
+	public:
+		//An empty value is a tombstone
+		using Entry = std::pair<Key, std::optional<Value>>;
+
+		explicit LsmStore(LsmOptions const& options = {}, Compare compare = {})
+			: _Options{ options }, _Compare{ std::move(compare) }
+		{
+			if (_Options.MaxRuns < 2)
+				throw std::invalid_argument{ "LsmStore: MaxRuns must be at least 2, a compaction merges two runs" };
+			if (_Options.FenceInterval == 0)
+				throw std::invalid_argument{ "LsmStore: FenceInterval must be at least 1" };
+			if (not (_Options.BloomBitsPerKey > 0))
+				throw std::invalid_argument{ "LsmStore: BloomBitsPerKey must be greater than 0" };
+			_Buffer.reserve(_Options.BufferCapacity);
+			if (_Options.BackgroundCompaction)
+				_Worker = std::jthread{ [this](std::stop_token const stop) { CompactionLoop(stop); } };
+		}
+
+		LsmStore(LsmStore const&) = delete;
+		LsmStore& operator=(LsmStore const&) = delete;
+
+		void Put(Key const& key, Value value)
+		{
+			Write(key, std::optional<Value>{ std::move(value) });
+		}
+
+		void Erase(Key const& key)
+		{
+			Write(key, std::nullopt);
+		}
+
+		std::optional<Value> Get(Key const& key) const
+		{
+			std::shared_lock const lock{ _Mutex };
+			if (auto const it{ _Buffer.find(key) }; it != _Buffer.end())
+				return it->second;
+			std::uint64_t const hash{ Hashing::Hash(key) };
+			for (auto const& run : _Runs)
+				if (auto const entry{ run->Find(key, hash, _Compare) })
+					return entry->second;
+			return std::nullopt;
+		}
+
+		bool Contains(Key const& key) const
+		{
+			return Get(key).has_value();
+		}
+
+		//Visit the live entries with first <= key < last in key order as fn(key, value).
+		//Works on a snapshot: writes and compactions during the scan are not seen and not blocked.
+		template<typename Fn>
+		void Scan(Key const& first, Key const& last, Fn fn) const
+		{
+			ScanSnapshot(&first, &last, fn);
+		}
+
+		template<typename Fn>
+		void ForEach(Fn fn) const
+		{
+			ScanSnapshot(nullptr, nullptr, fn);
+		}
+
+		//Turn the write buffer into a run
+		void Flush()
+		{
+			std::unique_lock lock{ _Mutex };
+			FlushLocked(lock);
+		}
+
+		//Block until no compaction is pending
+		void WaitForCompaction()
+		{
+			std::unique_lock lock{ _Mutex };
+			_CompactionDone.wait(lock, [this] { return _Runs.size() <= _Options.MaxRuns; });
+		}
+
+		std::size_t RunCount() const
+		{
+			std::shared_lock const lock{ _Mutex };
+			return _Runs.size();
+		}
+
+		std::size_t CompactionCount() const
+		{
+			std::shared_lock const lock{ _Mutex };
+			return _Compactions;
+		}
+
+		//Entries in the buffer and all runs, including tombstones and shadowed versions
+		std::size_t StoredEntryCount() const
+		{
+			std::shared_lock const lock{ _Mutex };
+			std::size_t count{ _Buffer.size() };
+			for (auto const& run : _Runs)
+				count += run->Entries().size();
+			return count;
+		}
+
+	private:
+		//Immutable sorted run with fence pointers and a Bloom filter
+		class Run
+		{
+		public:
+			Run(std::vector<Entry> entries, LsmOptions const& options)
+				: _Entries{ std::move(entries) }, _Filter{ _Entries.size(), options.BloomBitsPerKey }, _FenceInterval{ options.FenceInterval }
+			{
+				_Fences.reserve(_Entries.size() / _FenceInterval + 1);
+				for (std::size_t i = 0; i < _Entries.size(); ++i)
+				{
+					if (i % _FenceInterval == 0)
+						_Fences.push_back(_Entries[i].first);
+					_Filter.Add(_Entries[i].first);
+				}
+			}
+
+			std::span<Entry const> Entries() const noexcept { return _Entries; }
+
+			//Position of the first entry with a key >= key: binary search over the fences, then within one block
+			std::size_t LowerBound(Key const& key, Compare const& compare) const
+			{
+				auto const block{ static_cast<std::size_t>(std::upper_bound(_Fences.begin(), _Fences.end(), key, compare) - _Fences.begin()) };
+				if (block == 0)
+					return 0;
+				auto const begin{ _Entries.begin() + static_cast<std::ptrdiff_t>((block - 1) * _FenceInterval) };
+				auto const end{ _Entries.begin() + static_cast<std::ptrdiff_t>(std::min(block * _FenceInterval, _Entries.size())) };
+				return static_cast<std::size_t>(std::lower_bound(begin, end, key, [&compare](Entry const& entry, Key const& k) { return compare(entry.first, k); }) - _Entries.begin());
+			}
+
+			Entry const* Find(Key const& key, std::uint64_t const hash, Compare const& compare) const
+			{
+				if (not _Filter.MayContainHash(hash))
+					return nullptr;
+				std::size_t const position{ LowerBound(key, compare) };
+				if (position == _Entries.size() or compare(key, _Entries[position].first))
+					return nullptr;
+				return &_Entries[position];
+			}
+
+		private:
+			std::vector<Entry> _Entries;
+			std::vector<Key> _Fences;
+			Filters::BloomFilter _Filter;
+			std::size_t _FenceInterval;
+		};
+
+		using RunPointer = std::shared_ptr<Run const>;
+
+		struct KeyHash
+		{
+			std::size_t operator()(Key const& key) const noexcept { return static_cast<std::size_t>(Hashing::Hash(key)); }
+		};
+
+		void Write(Key const& key, std::optional<Value> value)
+		{
+			std::unique_lock lock{ _Mutex };
+			_Buffer.insert_or_assign(key, std::move(value));
+			if (_Buffer.size() >= _Options.BufferCapacity)
+				FlushLocked(lock);
+		}
+
+		void FlushLocked(std::unique_lock<std::shared_mutex>& lock)
+		{
+			if (_Buffer.empty())
+				return;
+			std::vector<Entry> entries;
+			entries.reserve(_Buffer.size());
+			for (auto& [key, value] : _Buffer)
+				entries.emplace_back(key, std::move(value));
+			_Buffer.clear();
+			std::ranges::sort(entries, _Compare, &Entry::first);
+			_Runs.insert(_Runs.begin(), std::make_shared<Run const>(std::move(entries), _Options));
+			if (_Runs.size() <= _Options.MaxRuns)
+				return;
+			if (_Options.BackgroundCompaction)
+				_CompactionWanted.notify_one();
+			else
+				while (_Runs.size() > _Options.MaxRuns)
+					CompactOnce(lock);
+		}
+
+		//Size-tiered choice: the newest runs, extended to older runs while they are not much larger than what is merged so far
+		std::vector<RunPointer> PickCompaction() const
+		{
+			std::vector<RunPointer> group{ _Runs[0], _Runs[1] };
+			std::size_t size{ _Runs[0]->Entries().size() + _Runs[1]->Entries().size() };
+			for (std::size_t i = 2; i < _Runs.size() and _Runs[i]->Entries().size() <= _Options.CompactionFanout * size; ++i)
+			{
+				group.push_back(_Runs[i]);
+				size += _Runs[i]->Entries().size();
+			}
+			return group;
+		}
+
+		//The worker merges a group of runs outside the lock, then swaps it in. Flushes only add newer runs in front,
+		//so the group stays contiguous. Without the worker the writer merges under the lock.
+		void CompactOnce(std::unique_lock<std::shared_mutex>& lock)
+		{
+			auto const group{ PickCompaction() };
+			bool const includesOldest{ group.back() == _Runs.back() };
+			bool const unlocked{ _Options.BackgroundCompaction };
+			if (unlocked)
+				lock.unlock();
+
+			std::vector<std::span<Entry const>> sources;
+			std::size_t size{ 0 };
+			for (auto const& run : group)
+			{
+				sources.push_back(run->Entries());
+				size += run->Entries().size();
+			}
+			std::vector<Entry> merged;
+			merged.reserve(size);
+			MergeNewest(sources, _Compare, [&](Entry const& entry) {
+				if (entry.second or not includesOldest) //nothing older is left for a tombstone to hide
+					merged.push_back(entry);
+			});
+			RunPointer run{ merged.empty() ? nullptr : std::make_shared<Run const>(std::move(merged), _Options) };
+
+			if (unlocked)
+				lock.lock();
+			auto const position{ std::ranges::find(_Runs, group.front()) };
+			auto const next{ _Runs.erase(position, position + static_cast<std::ptrdiff_t>(group.size())) };
+			if (run)
+				_Runs.insert(next, std::move(run));
+			++_Compactions;
+		}
+
+		void CompactionLoop(std::stop_token const stop)
+		{
+			std::unique_lock lock{ _Mutex };
+			while (_CompactionWanted.wait(lock, stop, [this] { return _Runs.size() > _Options.MaxRuns; }))
+			{
+				CompactOnce(lock);
+				_CompactionDone.notify_all();
+			}
+		}
+
+		//k-way merge with a loser tree; sources are ordered newest first and only the newest version of a key is emitted
+		template<typename Fn>
+		static void MergeNewest(std::span<std::span<Entry const> const> const sources, Compare const& compare, Fn&& fn)
+		{
+			auto const byKey = [&compare](Entry const* a, Entry const* b) { return compare(a->first, b->first); };
+			std::vector<std::optional<Entry const*>> heads;
+			heads.reserve(sources.size());
+			for (auto const& source : sources)
+				heads.push_back(source.empty() ? std::nullopt : std::optional{ source.data() });
+			Merging::LoserTree<Entry const*, decltype(byKey)> tree{ std::move(heads), byKey };
+			Entry const* previous{ nullptr };
+			while (not tree.Empty())
+			{
+				std::size_t const source{ tree.TopSource() };
+				Entry const* const entry{ tree.Top() };
+				//Ties go to the lower source index, so the first entry of every key is the newest
+				if (previous == nullptr or compare(previous->first, entry->first))
+				{
+					fn(*entry);
+					previous = entry;
+				}
+				Entry const* const next{ entry + 1 };
+				tree.ReplaceTop(next == sources[source].data() + sources[source].size() ? std::nullopt : std::optional{ next });
+			}
+		}
+
+		template<typename Fn>
+		void ScanSnapshot(Key const* first, Key const* last, Fn& fn) const
+		{
+			auto const inRange = [&](Key const& key) {
+				return (first == nullptr or not _Compare(key, *first)) and (last == nullptr or _Compare(key, *last));
+			};
+			std::vector<Entry> buffered;
+			std::vector<RunPointer> runs;
+			{
+				std::shared_lock const lock{ _Mutex };
+				for (auto const& entry : _Buffer)
+					if (inRange(entry.first))
+						buffered.push_back(entry);
+				runs = _Runs;
+			}
+			std::ranges::sort(buffered, _Compare, &Entry::first);
+
+			std::vector<std::span<Entry const>> sources{ buffered };
+			for (auto const& run : runs)
+			{
+				auto const entries{ run->Entries() };
+				std::size_t const begin{ first == nullptr ? 0 : run->LowerBound(*first, _Compare) };
+				std::size_t const end{ last == nullptr ? entries.size() : run->LowerBound(*last, _Compare) };
+				sources.push_back(entries.subspan(begin, end - std::min(begin, end)));
+			}
+			MergeNewest(sources, _Compare, [&](Entry const& entry) {
+				if (entry.second)
+					fn(entry.first, *entry.second);
+			});
+		}
+
+		LsmOptions _Options;
+		Compare _Compare;
+		mutable std::shared_mutex _Mutex;
+		std::condition_variable_any _CompactionWanted;
+		std::condition_variable_any _CompactionDone;
+		std::unordered_map<Key, std::optional<Value>, KeyHash> _Buffer;
+		std::vector<RunPointer> _Runs; //newest first
+		std::size_t _Compactions{ 0 };
+		std::jthread _Worker; //last member: stopped and joined first on destruction
+	};
+}
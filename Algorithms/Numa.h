@@ -0,0 +1,175 @@
+#pragma once
+
+#include "pch.h"
+#include "Parallel.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//NUMA-aware allocation for large vectors.
+//Linux only: on other platforms the placement is ignored and memory comes from the default heap.
+
+namespace Memory
+{
+	enum class NumaPlacement
+	{
+		FirstTouch,		//pages land on the node of the thread that first writes them
+		Interleaved,	//pages are spread round robin over all nodes
+		Partitioned		//parallel first touch by Parallel::ForEachPartition, whose pinned workers later find their chunk local
+	};
+
+	//Number of NUMA nodes of this machine (1 if unknown)
+	inline unsigned NumaNodeCount()
+	{
+#if defined(__linux__)
+		static unsigned const nodes = [] {
+			unsigned count{ 0 };
+			std::error_code error;
+			for (auto const& entry : std::filesystem::directory_iterator{ "/sys/devices/system/node", error })
+			{
+				auto const name{ entry.path().filename().string() };
+				if (name.starts_with("node") and name.size() > 4 and std::isdigit(static_cast<unsigned char>(name[4])))
+					++count;
+			}
+			return std::max(1u, count);
+		}();
+		return nodes;
+#else
+		return 1;
+#endif
+	}
+
+#if defined(__linux__)
+	namespace Detail
+	{
+		inline constexpr int MpolInterleave{ 3 }; //from <numaif.h>, which is not always installed
+
+		//Interleave the pages of [address, address + bytes) over all nodes
+		inline void Interleave(void* address, std::size_t const bytes)
+		{
+			unsigned const nodes{ NumaNodeCount() };
+			if (nodes < 2)
+				return;
+			std::vector<unsigned long> mask((nodes + 63) / 64);
+			for (unsigned node = 0; node < nodes; ++node)
+				mask[node / 64] |= 1ul << (node % 64);
+			//Best effort: if mbind is not allowed the pages simply stay with the default policy
+			::syscall(SYS_mbind, address, bytes, MpolInterleave, mask.data(), nodes + 1, 0);
+		}
+
+		inline std::size_t PageAlign(std::size_t const bytes)
+		{
+			static std::size_t const pageSize{ static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) };
+			return (bytes + pageSize - 1) / pageSize * pageSize;
+		}
+	}
+#endif
+
+	//Allocator that maps fresh pages and applies a NUMA placement
+	template<typename T>
+	class NumaAllocator
+	{
+	public:
+		using value_type = T;
+
+		NumaAllocator(NumaPlacement const placement = NumaPlacement::Interleaved) noexcept : _Placement{ placement } {}
+		template<typename U>
+		NumaAllocator(NumaAllocator<U> const& other) noexcept : _Placement{ other.Placement() } {}
+
+		T* allocate(std::size_t const count)
+		{
+			if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+				throw std::bad_array_new_length{};
+#if defined(__linux__)
+			std::size_t const bytes{ Detail::PageAlign(count * sizeof(T)) };
+			void* memory{ ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+			if (memory == MAP_FAILED)
+				throw std::bad_alloc{};
+			if (_Placement == NumaPlacement::Interleaved)
+				Detail::Interleave(memory, bytes);
+			return static_cast<T*>(memory);
+#else
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ alignof(T) }));
+#endif
+		}
+
+		void deallocate(T* pointer, std::size_t const count) noexcept
+		{
+#if defined(__linux__)
+			::munmap(pointer, Detail::PageAlign(count * sizeof(T)));
+#else
+			::operator delete(pointer, std::align_val_t{ alignof(T) });
+#endif
+		}
+
+		NumaPlacement Placement() const noexcept
+		{
+			return _Placement;
+		}
+
+		template<typename U>
+		bool operator==(NumaAllocator<U> const&) const noexcept
+		{
+			return true; //memory from any instance can be freed by any other
+		}
+
+	private:
+		NumaPlacement _Placement;
+	};
+
+	//NumaAllocator whose construct() without arguments default-initializes: vector(n) and resize(n) leave trivial elements
+	//indeterminate, like new T[n], and do not touch (and so place) the pages
+	template<typename T>
+	class DefaultInitNumaAllocator : public NumaAllocator<T>
+	{
+	public:
+		using NumaAllocator<T>::NumaAllocator;
+
+		template<typename U, typename... Args>
+		void construct(U* pointer, Args&&... args)
+		{
+			if constexpr (sizeof...(Args) == 0)
+				::new(static_cast<void*>(pointer)) U; //default-init: no write for trivial types
+			else
+				::new(static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+		}
+	};
+
+	template<typename T>
+	using NumaVector = std::vector<T, NumaAllocator<T>>;
+
+	//Vector whose new elements are default-initialized (uninitialized for trivial types), see DefaultInitNumaAllocator
+	template<typename T>
+	using DefaultInitNumaVector = std::vector<T, DefaultInitNumaAllocator<T>>;
+
+	//Create a vector of count elements with element i = init(i).
+	//The elements are written in parallel by Parallel::ForEachPartition (first touch),
+	//unless placement is FirstTouch, which initializes on the calling thread.
+	//T must be trivially default constructible: the vector is sized without touching the pages, and only init writes them.
+	template<typename T, typename Init>
+		requires std::is_trivially_default_constructible_v<T> and std::convertible_to<std::invoke_result_t<Init&, std::size_t>, T>
+	DefaultInitNumaVector<T> MakeNumaVector(std::size_t const count, NumaPlacement const placement, Init init, unsigned const threads = Parallel::ThreadCount())
+	{
+		DefaultInitNumaVector<T> v(DefaultInitNumaAllocator<T>{ placement });
+		v.resize(count);
+		auto const fill = [&v, &init](unsigned, Parallel::Range const range) {
+			for (std::size_t i = range.Begin; i < range.End; ++i)
+				v[i] = init(i);
+		};
+		if (placement == NumaPlacement::FirstTouch)
+			fill(0u, Parallel::Range{ 0, count });
+		else
+			Parallel::ForEachPartition(count, fill, threads);
+		return v;
+	}
+
+	//NUMA version of std::iota: the numbers start, start + 1, ...
+	template<typename T>
+	DefaultInitNumaVector<T> MakeNumaIota(std::size_t const count, T const start, NumaPlacement const placement = NumaPlacement::Partitioned)
+	{
+		return MakeNumaVector<T>(count, placement, [start](std::size_t const i) { return static_cast<T>(start + i); });
+	}
+}
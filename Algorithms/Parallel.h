@@ -0,0 +1,122 @@
+#pragma once
+
+#include "pch.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+//Static work partitioning shared by the parallel kernels and the NUMA first-touch initialization.
+//Partition i of a range always covers the same elements, and on Linux it always runs on the same CPU (of the CPUs the
+//process may use), so data initialized by partition i lies on the node where partition i later processes it.
+
+namespace Parallel
+{
+	//Number of worker threads used by the parallel kernels
+	inline unsigned ThreadCount() noexcept
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	//Half open range [Begin, End) of one partition
+	struct Range
+	{
+		std::size_t Begin{ 0 };
+		std::size_t End{ 0 };
+	};
+
+	//The index-th of parts equally sized partitions of [0, count)
+	inline Range Partition(std::size_t const count, unsigned const parts, unsigned const index) noexcept
+	{
+		std::size_t const chunk{ count / parts };
+		std::size_t const remainder{ count % parts };
+		std::size_t const begin{ index * chunk + std::min<std::size_t>(index, remainder) };
+		return { begin, begin + chunk + (index < remainder ? 1 : 0) };
+	}
+
+	//Number of partitions ForEachPartition uses for count elements: at most one per thread and none of them empty
+	inline unsigned PartitionCount(std::size_t const count, unsigned const threads = ThreadCount()) noexcept
+	{
+		return static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(count, 1)));
+	}
+
+	namespace Detail
+	{
+#if defined(__linux__)
+		//CPUs the process may run on, in ascending order (empty if unknown)
+		inline std::vector<int> const& AllowedCpus()
+		{
+			static std::vector<int> const cpus = [] {
+				std::vector<int> result;
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+					for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+						if (CPU_ISSET(cpu, &set))
+							result.push_back(cpu);
+				return result;
+			}();
+			return cpus;
+		}
+#endif
+
+		//Binds the current thread to the CPU of partition index of parts while it exists, then restores the previous affinity.
+		//Best effort: without permission the thread just keeps running where the scheduler puts it.
+		class PartitionAffinity
+		{
+		public:
+			PartitionAffinity(unsigned const index, unsigned const parts) noexcept
+			{
+#if defined(__linux__)
+				auto const& cpus{ AllowedCpus() };
+				if (cpus.empty() or ::sched_getaffinity(0, sizeof(_Previous), &_Previous) != 0)
+					return;
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				CPU_SET(cpus[static_cast<std::size_t>(index) * cpus.size() / parts], &set);
+				_Pinned = ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+				(void)index;
+				(void)parts;
+#endif
+			}
+			~PartitionAffinity()
+			{
+#if defined(__linux__)
+				if (_Pinned)
+					::sched_setaffinity(0, sizeof(_Previous), &_Previous);
+#endif
+			}
+			PartitionAffinity(PartitionAffinity const&) = delete;
+			PartitionAffinity& operator=(PartitionAffinity const&) = delete;
+
+		private:
+#if defined(__linux__)
+			cpu_set_t _Previous;
+			bool _Pinned{ false };
+#endif
+		};
+	}
+
+	//Call fn(index, range) for every partition of [0, count), each on its own thread pinned to the partition's CPU
+	template<typename Fn>
+	void ForEachPartition(std::size_t const count, Fn&& fn, unsigned threads = ThreadCount())
+	{
+		threads = PartitionCount(count, threads);
+		if (threads == 1)
+		{
+			fn(0u, Range{ 0, count });
+			return;
+		}
+		std::vector<std::jthread> workers;
+		workers.reserve(threads - 1);
+		for (unsigned i = 1; i < threads; ++i)
+			workers.emplace_back([&fn, count, threads, i] {
+				Detail::PartitionAffinity const affinity{ i, threads };
+				fn(i, Partition(count, threads, i));
+			});
+		//The calling thread takes the first partition and gets its own affinity back afterwards
+		Detail::PartitionAffinity const affinity{ 0, threads };
+		fn(0u, Partition(count, threads, 0));
+	}
+}
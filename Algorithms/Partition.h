@@ -0,0 +1,139 @@
+#pragma once
+
+#include "pch.h"
+
+//Block-based partition (BlockQuicksort): the predicate is evaluated for a block of elements at a time and the offsets of
+//the misplaced ones are written to a small buffer without branching (offset[count] = i; count += misplaced).
+//The elements are then moved in a loop whose trip count is known, so a random predicate costs no mispredictions.
+//Partition is unstable like std::partition; StablePartition keeps the relative order like std::stable_partition
+//and moves the rejected elements through a buffer. Both evaluate the predicate once per element.
+
+namespace FastPath
+{
+	namespace Detail
+	{
+		inline constexpr std::size_t PartitionBlock{ 64 };
+	}
+
+	//Move the elements for which pred is true before the others; returns the first element of the second group
+	template<std::random_access_iterator It, typename Predicate>
+		requires std::indirect_unary_predicate<Predicate&, It>
+	It Partition(It first, It last, Predicate pred)
+	{
+		constexpr std::size_t Block{ Detail::PartitionBlock };
+		using Difference = std::iter_difference_t<It>;
+		constexpr auto BlockSize{ static_cast<Difference>(Block) };
+		//[first, left) satisfies pred, [right, last) does not; a pending block keeps left or right in place
+		It left{ first };
+		It right{ last };
+		std::array<std::uint8_t, Block> leftOffsets;
+		std::array<std::uint8_t, Block> rightOffsets;
+		std::size_t leftStart{ 0 };
+		std::size_t leftCount{ 0 };
+		std::size_t rightStart{ 0 };
+		std::size_t rightCount{ 0 };
+		while (right - left > 2 * BlockSize)
+		{
+			if (leftCount == 0)
+			{
+				leftStart = 0;
+				for (std::size_t i = 0; i < Block; ++i)
+				{
+					leftOffsets[leftCount] = static_cast<std::uint8_t>(i);
+					leftCount += not static_cast<bool>(std::invoke(pred, left[static_cast<Difference>(i)]));
+				}
+			}
+			if (rightCount == 0)
+			{
+				rightStart = 0;
+				for (std::size_t i = 0; i < Block; ++i)
+				{
+					rightOffsets[rightCount] = static_cast<std::uint8_t>(i);
+					rightCount += static_cast<bool>(std::invoke(pred, right[-1 - static_cast<Difference>(i)]));
+				}
+			}
+			std::size_t const count{ std::min(leftCount, rightCount) };
+			for (std::size_t i = 0; i < count; ++i)
+				std::ranges::iter_swap(left + leftOffsets[leftStart + i], right - 1 - rightOffsets[rightStart + i]);
+			leftStart += count;
+			leftCount -= count;
+			rightStart += count;
+			rightCount -= count;
+			if (leftCount == 0)
+				left += BlockSize;
+			if (rightCount == 0)
+				right -= BlockSize;
+		}
+		//At most two blocks are left, and at most one of them has pending offsets. The rest is partitioned normally,
+		//then the misplaced elements of the pending block are swapped to the boundary, the farthest first.
+		if (leftCount > 0)
+		{
+			It middle{ std::partition(left + BlockSize, right, std::ref(pred)) };
+			for (std::size_t i = leftCount; i-- > 0;)
+				std::ranges::iter_swap(left + leftOffsets[leftStart + i], --middle);
+			return middle;
+		}
+		if (rightCount > 0)
+		{
+			It middle{ std::partition(left, right - BlockSize, std::ref(pred)) };
+			for (std::size_t i = rightCount; i-- > 0;)
+				std::ranges::iter_swap(right - 1 - rightOffsets[rightStart + i], middle++);
+			return middle;
+		}
+		return std::partition(left, right, std::ref(pred));
+	}
+
+	template<std::ranges::random_access_range R, typename Predicate>
+		requires std::indirect_unary_predicate<Predicate&, std::ranges::iterator_t<R>>
+	std::ranges::iterator_t<R> Partition(R&& range, Predicate pred)
+	{
+		return Partition(std::ranges::begin(range), std::ranges::end(range), std::move(pred));
+	}
+
+	//Stable variant: accepted elements are compacted in place and rejected ones moved to a buffer, a block at a time,
+	//then the buffer is moved behind the accepted elements. Needs room for the rejected elements.
+	template<std::random_access_iterator It, typename Predicate>
+		requires std::indirect_unary_predicate<Predicate&, It> and std::move_constructible<std::iter_value_t<It>>
+	It StablePartition(It first, It last, Predicate pred)
+	{
+		constexpr std::size_t Block{ Detail::PartitionBlock };
+		using Difference = std::iter_difference_t<It>;
+		//Elements before the first rejected one stay where they are; from then on the write position trails the read position
+		It write{ std::find_if_not(first, last, std::ref(pred)) };
+		if (write == last)
+			return last;
+		std::vector<std::iter_value_t<It>> rejected;
+		rejected.reserve(static_cast<std::size_t>(last - write));
+		rejected.push_back(std::ranges::iter_move(write));
+		std::array<std::uint8_t, Block> acceptedOffsets;
+		std::array<std::uint8_t, Block> rejectedOffsets;
+		for (It read = write + 1; read != last;)
+		{
+			auto const size{ static_cast<std::size_t>(std::min<Difference>(last - read, static_cast<Difference>(Block))) };
+			std::size_t acceptedCount{ 0 };
+			std::size_t rejectedCount{ 0 };
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				bool const accepted{ static_cast<bool>(std::invoke(pred, read[static_cast<Difference>(i)])) };
+				acceptedOffsets[acceptedCount] = static_cast<std::uint8_t>(i);
+				rejectedOffsets[rejectedCount] = static_cast<std::uint8_t>(i);
+				acceptedCount += accepted;
+				rejectedCount += not accepted;
+			}
+			for (std::size_t i = 0; i < rejectedCount; ++i)
+				rejected.push_back(std::ranges::iter_move(read + rejectedOffsets[i]));
+			for (std::size_t i = 0; i < acceptedCount; ++i)
+				*write++ = std::ranges::iter_move(read + acceptedOffsets[i]);
+			read += static_cast<Difference>(size);
+		}
+		std::ranges::move(rejected, write);
+		return write;
+	}
+
+	template<std::ranges::random_access_range R, typename Predicate>
+		requires std::indirect_unary_predicate<Predicate&, std::ranges::iterator_t<R>>
+	std::ranges::iterator_t<R> StablePartition(R&& range, Predicate pred)
+	{
+		return StablePartition(std::ranges::begin(range), std::ranges::end(range), std::move(pred));
+	}
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "Bits.h"
+
+//Applying a permutation. In gather form position i of the result receives the element that was at order[i] (what
+//FastPath::SortedOrder returns); in scatter form the element at i moves to destinations[i] (what a partition or a
+//counting pass produces). Either way one side is accessed in random order, one cache miss (and often a TLB miss) per element.
+//Gather hides part of that with software prefetch. A scatter of small trivially copyable elements is done in two passes
+//through buckets of destinations, so that every pass reads sequentially and writes either to a few dozen sequential streams
+//or inside one cache sized window. ApplyInPlace needs no second buffer.
+
+namespace Permutations
+{
+	//Elements the bucketed engine can stage: copied bytewise and created without initialization
+	template<typename T>
+	concept Bucketable = Traits::TriviallyCopyable<T> and std::default_initializable<T>;
+
+	//Below this size the whole permutation fits in cache and bucketing does not pay
+	inline constexpr std::size_t BucketedThreshold{ 1 << 17 };
+
+	namespace Detail
+	{
+		inline constexpr std::size_t WindowBytes{ 256 * 1024 };
+		inline constexpr std::size_t MaxBuckets{ 64 };
+		inline constexpr std::size_t PrefetchDistance{ 16 };
+
+		inline void Prefetch([[maybe_unused]] void const* const address) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(address);
+#endif
+		}
+
+		//Destinations that share index >> shift form one bucket; a bucket's window of the target stays cache resident
+		template<typename T>
+		unsigned BucketShift(std::size_t const count) noexcept
+		{
+			unsigned shift{ static_cast<unsigned>(std::bit_width(std::max<std::size_t>(1, WindowBytes / sizeof(T)))) - 1 };
+			while ((count >> shift) > MaxBuckets)
+				++shift;
+			return shift;
+		}
+
+		template<typename T>
+		struct Staged
+		{
+			std::uint32_t Destination;
+			T Value;
+		};
+
+		template<typename T>
+		void CheckSizes(std::span<T> const values, std::span<std::uint32_t const> const order, char const* const what)
+		{
+			if (order.size() != values.size())
+				throw std::length_error{ std::string{ what } + ": order and values differ in size" };
+		}
+	}
+
+	//target[destinations[i]] = source[i]. Pass one reads the source sequentially and appends each element to the bucket
+	//of its destination; pass two empties the buckets one by one, each writing only inside its own window of the target.
+	template<Bucketable T>
+	void BucketedScatter(std::span<T const> const source, std::span<std::uint32_t const> const destinations, std::span<T> const target)
+	{
+		std::size_t const count{ source.size() };
+		if (destinations.size() != count or target.size() != count)
+			throw std::length_error{ "BucketedScatter: sizes differ" };
+		unsigned const shift{ Detail::BucketShift<T>(count) };
+		std::size_t const buckets{ (count >> shift) + 1 };
+
+		std::vector<std::size_t> offsets(buckets + 1);
+		for (auto const destination : destinations)
+			++offsets[(destination >> shift) + 1];
+		std::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+		auto const staged{ std::make_unique_for_overwrite<Detail::Staged<T>[]>(count) };
+		std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < count; ++i)
+			staged[next[destinations[i] >> shift]++] = { destinations[i], source[i] };
+		for (std::size_t i = 0; i < count; ++i)
+			target[staged[i].Destination] = staged[i].Value;
+	}
+
+	//The scatter form of a gather order: inverse[order[i]] == i
+	inline std::vector<std::uint32_t> Invert(std::span<std::uint32_t const> const order)
+	{
+		std::vector<std::uint32_t> inverse(order.size());
+		if (order.size() < BucketedThreshold)
+		{
+			for (std::size_t i = 0; i < order.size(); ++i)
+				inverse[order[i]] = static_cast<std::uint32_t>(i);
+			return inverse;
+		}
+		std::vector<std::uint32_t> positions(order.size());
+		std::iota(positions.begin(), positions.end(), std::uint32_t{ 0 });
+		BucketedScatter<std::uint32_t>(positions, order, inverse);
+		return inverse;
+	}
+
+	//Out-of-place gather for any move constructible element; the source is prefetched a few elements ahead
+	template<typename T> requires std::move_constructible<T>
+	void Gather(std::vector<T>& values, std::span<std::uint32_t const> const order)
+	{
+		Detail::CheckSizes(std::span{ values }, order, "Gather");
+		std::vector<T> gathered;
+		gathered.reserve(order.size());
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			if (i + Detail::PrefetchDistance < order.size())
+				Detail::Prefetch(values.data() + order[i + Detail::PrefetchDistance]);
+			gathered.push_back(std::move(values[order[i]]));
+		}
+		values.swap(gathered);
+	}
+
+	//In place by following the cycles of the permutation: every element is moved once plus one temporary per cycle.
+	//A bitmap (n / 8 bytes) records the positions that are already filled.
+	template<typename T> requires std::move_constructible<T> and std::is_move_assignable_v<T>
+	void ApplyInPlace(std::span<T> const values, std::span<std::uint32_t const> const order)
+	{
+		Detail::CheckSizes(values, order, "ApplyInPlace");
+		std::vector<std::uint64_t> filled((values.size() + 63) / 64);
+		for (std::size_t leader = 0; leader < values.size(); ++leader)
+		{
+			if (Bits::Get(filled, leader))
+				continue;
+			Bits::Set(filled, leader, true);
+			if (order[leader] == leader)
+				continue;
+			T carried{ std::move(values[leader]) };
+			std::size_t position{ leader };
+			for (std::size_t from = order[position]; from != leader; from = order[position])
+			{
+				Detail::Prefetch(values.data() + order[from]);
+				values[position] = std::move(values[from]);
+				position = from;
+				Bits::Set(filled, position, true);
+			}
+			values[position] = std::move(carried);
+		}
+	}
+
+	//Out-of-place for a permutation in scatter form: afterwards position destinations[i] holds the element that was at i.
+	//Large arrays of small trivially copyable elements go through BucketedScatter; elements that cannot be default constructed
+	//are gathered through the inverse.
+	template<typename T> requires std::move_constructible<T>
+	void Scatter(std::vector<T>& values, std::span<std::uint32_t const> const destinations)
+	{
+		if constexpr (Bucketable<T> and sizeof(T) <= 16)
+		{
+			if (values.size() >= BucketedThreshold)
+			{
+				std::vector<T> result(values.size());
+				BucketedScatter<T>(values, destinations, result);
+				values.swap(result);
+				return;
+			}
+		}
+		Detail::CheckSizes(std::span{ values }, destinations, "Scatter");
+		if constexpr (std::default_initializable<T> and std::is_move_assignable_v<T>)
+		{
+			std::vector<T> result(values.size());
+			for (std::size_t i = 0; i < values.size(); ++i)
+				result[destinations[i]] = std::move(values[i]);
+			values.swap(result);
+		}
+		else
+			Gather(values, Invert(destinations));
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "pch.h"
+
+//KLL quantile sketch: approximate percentiles (e.g. of Product::Price()) without sorting the data.
+//The rank error is about 1.7 / k with high probability (about 1% for the default k = 200)
+//and the sketch keeps O(k) values regardless of the number of values added.
+//Sketches that are merged need different seeds: with equal seeds they make the same compaction choices, and the errors add up.
+
+namespace Sketches
+{
+	class KllSketch
+	{
+	public:
+		static constexpr std::size_t DefaultK{ 200 };
+
+		explicit KllSketch(std::size_t const k = DefaultK, std::uint64_t const seed = 42) : _K{ std::max<std::size_t>(k, 8) }, _Random{ seed }
+		{
+			AddLevel();
+		}
+
+		void Add(double const value)
+		{
+			_Levels[0].push_back(value);
+			_Min = std::min(_Min, value);
+			_Max = std::max(_Max, value);
+			++_Count;
+			if (++_Size > _Capacity)
+				Compress();
+		}
+
+		//Add all values of a range, optionally through a projection: sketch.AddRange(products, &Product::Price)
+		template<std::ranges::input_range R, typename Projection = std::identity>
+		void AddRange(R const& range, Projection projection = {})
+		{
+			for (auto const& item : range)
+				Add(static_cast<double>(std::invoke(projection, item)));
+		}
+
+		//Combine with another sketch (e.g. from another thread or shard)
+		void Merge(KllSketch const& other)
+		{
+			if (&other == this)
+				throw std::invalid_argument{ "KllSketch: cannot merge a sketch into itself" };
+			while (_Levels.size() < other._Levels.size())
+				AddLevel();
+			for (std::size_t level = 0; level < other._Levels.size(); ++level)
+				_Levels[level].insert(_Levels[level].end(), other._Levels[level].begin(), other._Levels[level].end());
+			_Size += other._Size;
+			_Count += other._Count;
+			_Min = std::min(_Min, other._Min);
+			_Max = std::max(_Max, other._Max);
+			while (_Size > _Capacity)
+				Compress();
+		}
+
+		//Approximate q-quantile (q in [0, 1]), e.g. Quantile(0.99) for p99. Sorts the O(k) retained values on every call,
+		//so concurrent queries need no synchronization.
+		double Quantile(double const q) const
+		{
+			if (_Count == 0)
+				return std::numeric_limits<double>::quiet_NaN();
+			if (q <= 0)
+				return _Min;
+			if (q >= 1)
+				return _Max;
+			auto const sorted{ SortedItems() };
+			auto const rank{ static_cast<std::uint64_t>(q * static_cast<double>(_Count)) };
+			auto const it{ std::ranges::upper_bound(sorted, rank, std::less<>{}, &WeightedItem::CumulativeWeight) };
+			return it == sorted.end() ? _Max : it->Value;
+		}
+
+		std::uint64_t Count() const noexcept { return _Count; }
+		double Min() const noexcept { return _Min; }
+		double Max() const noexcept { return _Max; }
+
+		//Number of values retained by the sketch
+		std::size_t RetainedCount() const noexcept { return _Size; }
+
+	private:
+		struct WeightedItem
+		{
+			double Value;
+			std::uint64_t CumulativeWeight; //total weight of all items up to and including this one
+		};
+
+		//Capacity of a level: k for the top level, shrinking by 2/3 per level below it
+		std::size_t LevelCapacity(std::size_t const level) const noexcept
+		{
+			auto const depth{ static_cast<double>(_Levels.size() - level - 1) };
+			return std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(_K * std::pow(2.0 / 3.0, depth))));
+		}
+
+		//Add a top level; the capacities of all levels change with the number of levels
+		void AddLevel()
+		{
+			_Levels.emplace_back();
+			_LevelCapacities.resize(_Levels.size());
+			_Capacity = 0;
+			for (std::size_t level = 0; level < _Levels.size(); ++level)
+				_Capacity += (_LevelCapacities[level] = LevelCapacity(level));
+		}
+
+		//Compact the lowest full level: sort it and promote every other item (random offset) to the next level,
+		//where each item counts twice as much
+		void Compress()
+		{
+			for (std::size_t level = 0; level < _Levels.size(); ++level)
+			{
+				if (_Levels[level].size() < _LevelCapacities[level])
+					continue;
+				if (level + 1 == _Levels.size())
+					AddLevel();
+				auto& items{ _Levels[level] };
+				std::sort(items.begin(), items.end());
+				std::optional<double> leftover;
+				if (items.size() % 2 == 1)
+				{
+					leftover = items.back();
+					items.pop_back();
+				}
+				std::size_t const offset{ _Random() & 1 };
+				auto& next{ _Levels[level + 1] };
+				for (std::size_t i = offset; i < items.size(); i += 2)
+					next.push_back(items[i]);
+				_Size -= items.size() / 2;
+				items.clear();
+				if (leftover)
+					items.push_back(*leftover);
+				return;
+			}
+		}
+
+		std::vector<WeightedItem> SortedItems() const
+		{
+			std::vector<WeightedItem> sorted;
+			sorted.reserve(_Size);
+			for (std::size_t level = 0; level < _Levels.size(); ++level)
+				for (double const value : _Levels[level])
+					sorted.push_back({ value, std::uint64_t{ 1 } << level });
+			std::ranges::sort(sorted, std::less<>{}, &WeightedItem::Value);
+			std::uint64_t cumulative{ 0 };
+			for (auto& item : sorted)
+				item.CumulativeWeight = (cumulative += item.CumulativeWeight);
+			return sorted;
+		}
+
+		std::size_t _K;
+		std::mt19937_64 _Random;
+		std::vector<std::vector<double>> _Levels;
+		std::vector<std::size_t> _LevelCapacities;
+		std::size_t _Capacity{ 0 };
+		std::size_t _Size{ 0 };
+		std::uint64_t _Count{ 0 };
+		double _Min{ std::numeric_limits<double>::infinity() };
+		double _Max{ -std::numeric_limits<double>::infinity() };
+	};
+}
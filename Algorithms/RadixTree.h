@@ -0,0 +1,559 @@
+#pragma once
+
+#include "pch.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//Adaptive radix tree (ART) over string keys. Inner nodes branch on one byte of the key and come in four sizes
+//(4, 16, 48 and 256 children), so sparse and dense nodes both stay small. Runs of bytes without branches are
+//stored once as the node prefix (path compression). Children are ordered by byte, so a depth-first walk
+//enumerates keys in sorted order, which makes prefix search (type-ahead) a descent plus a subtree walk.
+
+namespace Indexes
+{
+	template<typename Value>
+	class AdaptiveRadixTree
+	{
+	public:
+		//Node counts and memory of the tree
+		struct Statistics
+		{
+			std::size_t Leaves{ 0 };
+			std::size_t Node4{ 0 };
+			std::size_t Node16{ 0 };
+			std::size_t Node48{ 0 };
+			std::size_t Node256{ 0 };
+			std::size_t Bytes{ 0 };	//nodes plus heap memory of keys and prefixes
+		};
+
+		AdaptiveRadixTree() noexcept = default;
+
+		AdaptiveRadixTree(AdaptiveRadixTree&& other) noexcept
+			: _Root{ std::exchange(other._Root, nullptr) }, _Size{ std::exchange(other._Size, 0) }
+		{
+		}
+
+		AdaptiveRadixTree& operator=(AdaptiveRadixTree&& other) noexcept
+		{
+			std::swap(_Root, other._Root);
+			std::swap(_Size, other._Size);
+			return *this;
+		}
+
+		~AdaptiveRadixTree()
+		{
+			Delete(_Root);
+		}
+
+		//Build from keys in strictly ascending order; values[i] belongs to sortedKeys[i].
+		//Every node is created with its final size, without the growth steps of single inserts.
+		template<typename Key>
+		static AdaptiveRadixTree BulkLoad(std::span<Key const> const sortedKeys, std::span<Value const> const values)
+		{
+			assert(sortedKeys.size() == values.size());
+			assert(std::ranges::adjacent_find(sortedKeys, std::greater_equal<>{}) == sortedKeys.end());
+			AdaptiveRadixTree tree;
+			if (not sortedKeys.empty())
+				tree._Root = Build(sortedKeys, values, 0, sortedKeys.size(), 0);
+			tree._Size = sortedKeys.size();
+			return tree;
+		}
+
+		//Insert or replace; returns true if the key was new
+		bool Insert(std::string_view const key, Value value)
+		{
+			bool const inserted{ Insert(_Root, key, 0, std::move(value)) };
+			_Size += inserted;
+			return inserted;
+		}
+
+		Value const* Find(std::string_view const key) const noexcept
+		{
+			Node const* node{ _Root };
+			std::size_t depth{ 0 };
+			while (node != nullptr)
+			{
+				if (node->Type == NodeType::Leaf)
+				{
+					auto const* leaf{ static_cast<Leaf const*>(node) };
+					return leaf->Key == key ? &leaf->Data : nullptr;
+				}
+				auto const* inner{ static_cast<Inner const*>(node) };
+				if (not key.substr(depth).starts_with(inner->Prefix))
+					return nullptr;
+				depth += inner->Prefix.size();
+				if (depth == key.size())
+					return inner->Terminal != nullptr ? &inner->Terminal->Data : nullptr;
+				node = FindChild(inner, static_cast<std::uint8_t>(key[depth++]));
+			}
+			return nullptr;
+		}
+
+		//Visit all keys starting with prefix in sorted order as fn(key, value).
+		//fn may return bool: false stops the enumeration (e.g. after the first ten type-ahead suggestions).
+		template<typename Fn>
+		void ForEachWithPrefix(std::string_view const prefix, Fn&& fn) const
+		{
+			Node const* node{ _Root };
+			std::size_t depth{ 0 };
+			while (node != nullptr and node->Type != NodeType::Leaf)
+			{
+				auto const* inner{ static_cast<Inner const*>(node) };
+				auto const rest{ prefix.substr(depth) };
+				if (rest.size() <= inner->Prefix.size())
+				{
+					//The query ends inside this node's prefix: everything below matches or nothing does
+					if (std::string_view{ inner->Prefix }.starts_with(rest))
+						Enumerate(node, fn);
+					return;
+				}
+				if (not rest.starts_with(inner->Prefix))
+					return;
+				depth += inner->Prefix.size();
+				node = FindChild(inner, static_cast<std::uint8_t>(prefix[depth++]));
+			}
+			if (node != nullptr and static_cast<Leaf const*>(node)->Key.starts_with(prefix))
+				Enumerate(node, fn);
+		}
+
+		//Up to limit keys with the prefix, in sorted order
+		std::vector<std::pair<std::string_view, Value>> PrefixSearch(std::string_view const prefix, std::size_t const limit) const
+		{
+			std::vector<std::pair<std::string_view, Value>> result;
+			if (limit == 0)
+				return result;
+			ForEachWithPrefix(prefix, [&](std::string_view const key, Value const& value) {
+				result.emplace_back(key, value);
+				return result.size() < limit;
+			});
+			return result;
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+
+		Statistics Stats() const
+		{
+			Statistics stats;
+			Collect(_Root, stats);
+			return stats;
+		}
+
+	private:
+		enum class NodeType : std::uint8_t { Leaf, Node4, Node16, Node48, Node256 };
+
+		struct Node
+		{
+			NodeType Type;
+		};
+
+		struct Leaf : Node
+		{
+			std::string Key;
+			Value Data;
+		};
+
+		struct Inner : Node
+		{
+			std::uint16_t Count{ 0 };
+			std::string Prefix;				//compressed path below the parent's branch byte
+			Leaf* Terminal{ nullptr };		//the key that ends exactly at this node
+		};
+
+		struct Node4 : Inner
+		{
+			std::array<std::uint8_t, 4> Keys{};
+			std::array<Node*, 4> Children{};
+		};
+
+		struct Node16 : Inner
+		{
+			alignas(16) std::array<std::uint8_t, 16> Keys{};
+			std::array<Node*, 16> Children{};
+		};
+
+		struct Node48 : Inner
+		{
+			std::array<std::uint8_t, 256> Slots{};	//0: no child, otherwise child index + 1
+			std::array<Node*, 48> Children{};
+		};
+
+		struct Node256 : Inner
+		{
+			std::array<Node*, 256> Children{};
+		};
+
+		template<typename T>
+		static T* Make(NodeType const type)
+		{
+			auto* node{ new T{} };
+			node->Type = type;
+			return node;
+		}
+
+		static Leaf* MakeLeaf(std::string_view const key, Value value)
+		{
+			auto* leaf{ Make<Leaf>(NodeType::Leaf) };
+			leaf->Key = key;
+			leaf->Data = std::move(value);
+			return leaf;
+		}
+
+		//Delete a subtree
+		static void Delete(Node* node) noexcept
+		{
+			if (node == nullptr)
+				return;
+			if (node->Type != NodeType::Leaf)
+			{
+				auto* inner{ static_cast<Inner*>(node) };
+				delete inner->Terminal;
+				ForEachChild(inner, [](std::uint8_t, Node* child) { Delete(child); return true; });
+			}
+			DeleteNode(node);
+		}
+
+		//Delete a single node, not its children
+		static void DeleteNode(Node* node) noexcept
+		{
+			switch (node->Type)
+			{
+			case NodeType::Leaf: delete static_cast<Leaf*>(node); break;
+			case NodeType::Node4: delete static_cast<Node4*>(node); break;
+			case NodeType::Node16: delete static_cast<Node16*>(node); break;
+			case NodeType::Node48: delete static_cast<Node48*>(node); break;
+			default: delete static_cast<Node256*>(node); break;
+			}
+		}
+
+		//Node16 compares the byte with all 16 keys in one SSE2 instruction
+		static Node* FindChild(Inner const* inner, std::uint8_t const byte) noexcept
+		{
+			switch (inner->Type)
+			{
+			case NodeType::Node4:
+			{
+				auto const* node{ static_cast<Node4 const*>(inner) };
+				for (std::size_t i = 0; i < node->Count; ++i)
+					if (node->Keys[i] == byte)
+						return node->Children[i];
+				return nullptr;
+			}
+			case NodeType::Node16:
+			{
+				auto const* node{ static_cast<Node16 const*>(inner) };
+#if defined(__SSE2__) || defined(_M_X64)
+				__m128i const matches{ _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), _mm_load_si128(reinterpret_cast<__m128i const*>(node->Keys.data()))) };
+				unsigned const mask{ static_cast<unsigned>(_mm_movemask_epi8(matches)) & ((1u << node->Count) - 1) };
+				return mask != 0 ? node->Children[static_cast<std::size_t>(std::countr_zero(mask))] : nullptr;
+#else
+				for (std::size_t i = 0; i < node->Count; ++i)
+					if (node->Keys[i] == byte)
+						return node->Children[i];
+				return nullptr;
+#endif
+			}
+			case NodeType::Node48:
+			{
+				auto const* node{ static_cast<Node48 const*>(inner) };
+				return node->Slots[byte] == 0 ? nullptr : node->Children[node->Slots[byte] - 1u];
+			}
+			default:
+				return static_cast<Node256 const*>(inner)->Children[byte];
+			}
+		}
+
+		static Node** FindChildSlot(Inner* inner, std::uint8_t const byte) noexcept
+		{
+			switch (inner->Type)
+			{
+			case NodeType::Node4:
+			case NodeType::Node16:
+			{
+				std::uint8_t* keys{ inner->Type == NodeType::Node4 ? static_cast<Node4*>(inner)->Keys.data() : static_cast<Node16*>(inner)->Keys.data() };
+				Node** children{ inner->Type == NodeType::Node4 ? static_cast<Node4*>(inner)->Children.data() : static_cast<Node16*>(inner)->Children.data() };
+				for (std::size_t i = 0; i < inner->Count; ++i)
+					if (keys[i] == byte)
+						return children + i;
+				return nullptr;
+			}
+			case NodeType::Node48:
+			{
+				auto* node{ static_cast<Node48*>(inner) };
+				return node->Slots[byte] == 0 ? nullptr : &node->Children[node->Slots[byte] - 1u];
+			}
+			default:
+			{
+				auto* node{ static_cast<Node256*>(inner) };
+				return node->Children[byte] == nullptr ? nullptr : &node->Children[byte];
+			}
+			}
+		}
+
+		//fn(byte, child) in ascending byte order while fn returns true
+		template<typename Fn>
+		static bool ForEachChild(Inner const* inner, Fn&& fn)
+		{
+			switch (inner->Type)
+			{
+			case NodeType::Node4:
+			{
+				auto const* node{ static_cast<Node4 const*>(inner) };
+				for (std::size_t i = 0; i < node->Count; ++i)
+					if (not fn(node->Keys[i], node->Children[i]))
+						return false;
+				return true;
+			}
+			case NodeType::Node16:
+			{
+				auto const* node{ static_cast<Node16 const*>(inner) };
+				for (std::size_t i = 0; i < node->Count; ++i)
+					if (not fn(node->Keys[i], node->Children[i]))
+						return false;
+				return true;
+			}
+			case NodeType::Node48:
+			{
+				auto const* node{ static_cast<Node48 const*>(inner) };
+				for (std::size_t byte = 0; byte < 256; ++byte)
+					if (node->Slots[byte] != 0 and not fn(static_cast<std::uint8_t>(byte), node->Children[node->Slots[byte] - 1u]))
+						return false;
+				return true;
+			}
+			default:
+			{
+				auto const* node{ static_cast<Node256 const*>(inner) };
+				for (std::size_t byte = 0; byte < 256; ++byte)
+					if (node->Children[byte] != nullptr and not fn(static_cast<std::uint8_t>(byte), node->Children[byte]))
+						return false;
+				return true;
+			}
+			}
+		}
+
+		//Move the header of a full node into the next larger node type
+		template<typename To>
+		static To* Grow(Inner* from, NodeType const type)
+		{
+			auto* to{ Make<To>(type) };
+			to->Prefix = std::move(from->Prefix);
+			to->Terminal = std::exchange(from->Terminal, nullptr);
+			ForEachChild(from, [to](std::uint8_t const byte, Node* child) { AddChild(to, byte, child); return true; });
+			return to;
+		}
+
+		//Add a child for a byte that has none yet; the node is replaced by a larger one if it is full
+		static void AddChildOrGrow(Node*& slot, std::uint8_t const byte, Node* child)
+		{
+			auto* inner{ static_cast<Inner*>(slot) };
+			Inner* grown{ nullptr };
+			if (inner->Type == NodeType::Node4 and inner->Count == 4)
+				grown = Grow<Node16>(inner, NodeType::Node16);
+			else if (inner->Type == NodeType::Node16 and inner->Count == 16)
+				grown = Grow<Node48>(inner, NodeType::Node48);
+			else if (inner->Type == NodeType::Node48 and inner->Count == 48)
+				grown = Grow<Node256>(inner, NodeType::Node256);
+			if (grown != nullptr)
+			{
+				DeleteNode(slot); //its children moved to the grown node
+				slot = grown;
+				inner = grown;
+			}
+			AddChild(inner, byte, child);
+		}
+
+		static void AddChild(Inner* inner, std::uint8_t const byte, Node* child)
+		{
+			switch (inner->Type)
+			{
+			case NodeType::Node4:
+				InsertSorted(static_cast<Node4*>(inner)->Keys.data(), static_cast<Node4*>(inner)->Children.data(), inner->Count, byte, child);
+				break;
+			case NodeType::Node16:
+				InsertSorted(static_cast<Node16*>(inner)->Keys.data(), static_cast<Node16*>(inner)->Children.data(), inner->Count, byte, child);
+				break;
+			case NodeType::Node48:
+			{
+				auto* node{ static_cast<Node48*>(inner) };
+				node->Children[node->Count] = child;
+				node->Slots[byte] = static_cast<std::uint8_t>(node->Count + 1);
+				break;
+			}
+			default:
+				static_cast<Node256*>(inner)->Children[byte] = child;
+				break;
+			}
+			++inner->Count;
+		}
+
+		static void InsertSorted(std::uint8_t* keys, Node** children, std::size_t const count, std::uint8_t const byte, Node* child)
+		{
+			std::size_t const position{ static_cast<std::size_t>(std::lower_bound(keys, keys + count, byte) - keys) };
+			std::copy_backward(keys + position, keys + count, keys + count + 1);
+			std::copy_backward(children + position, children + count, children + count + 1);
+			keys[position] = byte;
+			children[position] = child;
+		}
+
+		static bool Insert(Node*& slot, std::string_view const key, std::size_t depth, Value value)
+		{
+			if (slot == nullptr)
+			{
+				slot = MakeLeaf(key, std::move(value));
+				return true;
+			}
+			if (slot->Type == NodeType::Leaf)
+			{
+				auto* leaf{ static_cast<Leaf*>(slot) };
+				if (leaf->Key == key)
+				{
+					leaf->Data = std::move(value);
+					return false;
+				}
+				//Split the leaf: a new node holds the common part of both keys and branches below it
+				std::string_view const existing{ leaf->Key };
+				std::size_t const common{ static_cast<std::size_t>(std::ranges::mismatch(existing.substr(depth), key.substr(depth)).in1 - existing.substr(depth).begin()) };
+				Node* split{ Make<Node4>(NodeType::Node4) };
+				static_cast<Inner*>(split)->Prefix = key.substr(depth, common);
+				Attach(split, existing, depth + common, leaf);
+				Attach(split, key, depth + common, MakeLeaf(key, std::move(value)));
+				slot = split;
+				return true;
+			}
+
+			auto* inner{ static_cast<Inner*>(slot) };
+			std::string_view const prefix{ inner->Prefix };
+			std::size_t const common{ static_cast<std::size_t>(std::ranges::mismatch(prefix, key.substr(depth)).in1 - prefix.begin()) };
+			if (common < prefix.size())
+			{
+				//The key leaves the compressed path: split the prefix at the first difference
+				Node* split{ Make<Node4>(NodeType::Node4) };
+				static_cast<Inner*>(split)->Prefix = prefix.substr(0, common);
+				std::uint8_t const branch{ static_cast<std::uint8_t>(prefix[common]) };
+				inner->Prefix.erase(0, common + 1);
+				AddChild(static_cast<Inner*>(split), branch, inner);
+				Attach(split, key, depth + common, MakeLeaf(key, std::move(value)));
+				slot = split;
+				return true;
+			}
+			depth += prefix.size();
+			if (depth == key.size())
+			{
+				if (inner->Terminal != nullptr)
+				{
+					inner->Terminal->Data = std::move(value);
+					return false;
+				}
+				inner->Terminal = MakeLeaf(key, std::move(value));
+				return true;
+			}
+			auto const byte{ static_cast<std::uint8_t>(key[depth]) };
+			if (Node** const child{ FindChildSlot(inner, byte) })
+				return Insert(*child, key, depth + 1, std::move(value));
+			AddChildOrGrow(slot, byte, MakeLeaf(key, std::move(value)));
+			return true;
+		}
+
+		//Hang a leaf below a new node whose prefix ends at depth: as terminal if the key ends there, else as a child
+		static void Attach(Node*& node, std::string_view const key, std::size_t const depth, Leaf* leaf)
+		{
+			if (key.size() == depth)
+				static_cast<Inner*>(node)->Terminal = leaf;
+			else
+				AddChildOrGrow(node, static_cast<std::uint8_t>(key[depth]), leaf);
+		}
+
+		//Build the subtree of the sorted keys [first, last), which agree on their first depth bytes
+		template<typename Key>
+		static Node* Build(std::span<Key const> const keys, std::span<Value const> const values, std::size_t first, std::size_t const last, std::size_t const depth)
+		{
+			if (last - first == 1)
+				return MakeLeaf(keys[first], values[first]);
+			//In a sorted range the first and the last key have the shortest common prefix
+			std::string_view const low{ keys[first] };
+			std::string_view const high{ keys[last - 1] };
+			std::size_t const common{ static_cast<std::size_t>(std::ranges::mismatch(low.substr(depth), high.substr(depth)).in1 - low.substr(depth).begin()) };
+			std::size_t const branchDepth{ depth + common };
+
+			Leaf* terminal{ nullptr };
+			if (low.size() == branchDepth)
+			{
+				terminal = MakeLeaf(keys[first], values[first]);
+				++first;
+			}
+			std::size_t children{ 0 };
+			for (std::size_t i = first; i < last; ++i)
+				children += i == first or std::string_view{ keys[i] }[branchDepth] != std::string_view{ keys[i - 1] }[branchDepth];
+
+			Inner* inner;
+			if (children <= 4)
+				inner = Make<Node4>(NodeType::Node4);
+			else if (children <= 16)
+				inner = Make<Node16>(NodeType::Node16);
+			else if (children <= 48)
+				inner = Make<Node48>(NodeType::Node48);
+			else
+				inner = Make<Node256>(NodeType::Node256);
+			inner->Prefix = low.substr(depth, common);
+			inner->Terminal = terminal;
+			for (std::size_t begin = first; begin < last;)
+			{
+				auto const byte{ static_cast<std::uint8_t>(std::string_view{ keys[begin] }[branchDepth]) };
+				std::size_t end{ begin + 1 };
+				while (end < last and static_cast<std::uint8_t>(std::string_view{ keys[end] }[branchDepth]) == byte)
+					++end;
+				AddChild(inner, byte, Build(keys, values, begin, end, branchDepth + 1));
+				begin = end;
+			}
+			return inner;
+		}
+
+		template<typename Fn>
+		static bool Enumerate(Node const* node, Fn& fn)
+		{
+			if (node->Type == NodeType::Leaf)
+			{
+				auto const* leaf{ static_cast<Leaf const*>(node) };
+				if constexpr (std::is_void_v<std::invoke_result_t<Fn&, std::string_view, Value const&>>)
+				{
+					fn(std::string_view{ leaf->Key }, leaf->Data);
+					return true;
+				}
+				else
+					return fn(std::string_view{ leaf->Key }, leaf->Data);
+			}
+			auto const* inner{ static_cast<Inner const*>(node) };
+			if (inner->Terminal != nullptr and not Enumerate(inner->Terminal, fn))
+				return false;
+			return ForEachChild(inner, [&fn](std::uint8_t, Node const* child) { return Enumerate(child, fn); });
+		}
+
+		static void Collect(Node const* node, Statistics& stats)
+		{
+			if (node == nullptr)
+				return;
+			auto const heapBytes = [](std::string const& text) { return text.capacity() > std::string{}.capacity() ? text.capacity() + 1 : 0; };
+			if (node->Type == NodeType::Leaf)
+			{
+				++stats.Leaves;
+				stats.Bytes += sizeof(Leaf) + heapBytes(static_cast<Leaf const*>(node)->Key);
+				return;
+			}
+			auto const* inner{ static_cast<Inner const*>(node) };
+			switch (node->Type)
+			{
+			case NodeType::Node4: ++stats.Node4; stats.Bytes += sizeof(Node4); break;
+			case NodeType::Node16: ++stats.Node16; stats.Bytes += sizeof(Node16); break;
+			case NodeType::Node48: ++stats.Node48; stats.Bytes += sizeof(Node48); break;
+			default: ++stats.Node256; stats.Bytes += sizeof(Node256); break;
+			}
+			stats.Bytes += heapBytes(inner->Prefix);
+			Collect(inner->Terminal, stats);
+			ForEachChild(inner, [&stats](std::uint8_t, Node const* child) { Collect(child, stats); return true; });
+		}
+
+		Node* _Root{ nullptr };
+		std::size_t _Size{ 0 };
+	};
+}
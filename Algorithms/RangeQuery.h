@@ -0,0 +1,190 @@
+#pragma once
+
+#include "pch.h"
+
+//Range minimum/maximum queries over static data: the best element of values[first, last) in O(1).
+//Compare picks the kind of query: std::less<> (the default) answers minima, std::greater<> maxima.
+//Both indexes can be built over a projection, e.g. the wallPoints[i] - lengths[i] / 4 of ContainerAlgorithm::Exercise16:
+//	RangeQueries::SparseTable<int, std::greater<>> highest{ std::views::iota(0, n), [&](int i) { return wallPoints[i] - lengths[i] / 4; } };
+
+namespace RangeQueries
+{
+	namespace Detail
+	{
+		inline void CheckRange(std::size_t const first, std::size_t const last, std::size_t const size)
+		{
+			if (first >= last or last > size)
+				throw std::out_of_range{ "RangeQueries: empty or invalid range" };
+		}
+
+		template<typename T, std::ranges::input_range R, typename Projection>
+		std::vector<T> Project(R&& range, Projection& projection)
+		{
+			std::vector<T> values;
+			if constexpr (std::ranges::sized_range<R>)
+				values.reserve(static_cast<std::size_t>(std::ranges::size(range)));
+			for (auto&& element : range)
+				values.push_back(static_cast<T>(std::invoke(projection, element)));
+			return values;
+		}
+	}
+
+	//Level j holds the best of every window of 2^j values; a query combines the two (overlapping) windows that cover it.
+	//n * (log2(n) + 1) values of memory, O(1) queries with two loads.
+	template<typename T, typename Compare = std::less<>>
+	class SparseTable
+	{
+	public:
+		SparseTable() = default;
+
+		explicit SparseTable(std::vector<T> values, Compare compare = {})
+			: _Compare{ std::move(compare) }, _Size{ values.size() }, _Values{ std::move(values) }
+		{
+			Build();
+		}
+
+		template<std::ranges::input_range R, typename Projection = std::identity>
+			requires std::regular_invocable<Projection&, std::ranges::range_reference_t<R>>
+		SparseTable(R&& range, Projection projection = {}, Compare compare = {})
+			: SparseTable(Detail::Project<T>(std::forward<R>(range), projection), std::move(compare))
+		{
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+		std::size_t ByteSize() const noexcept { return _Values.size() * sizeof(T) + _Offsets.size() * sizeof(std::size_t); }
+
+		//Best value of [first, last); throws std::out_of_range for an empty or invalid range
+		T Query(std::size_t const first, std::size_t const last) const
+		{
+			Detail::CheckRange(first, last, _Size);
+			auto const level{ static_cast<std::size_t>(std::bit_width(last - first)) - 1 };
+			T const* const values{ _Values.data() + _Offsets[level] };
+			T const& left{ values[first] };
+			T const& right{ values[last - (std::size_t{ 1 } << level)] };
+			return _Compare(right, left) ? right : left;
+		}
+
+	private:
+		//All levels live in one vector: level j starts at _Offsets[j] and has n - 2^j + 1 entries
+		void Build()
+		{
+			std::size_t const levels{ _Size == 0 ? 0 : static_cast<std::size_t>(std::bit_width(_Size)) };
+			_Offsets.assign(std::max<std::size_t>(levels, 1), 0);
+			std::size_t total{ _Size };
+			for (std::size_t level = 1; level < levels; ++level)
+			{
+				_Offsets[level] = total;
+				total += _Size - (std::size_t{ 1 } << level) + 1;
+			}
+			_Values.resize(total);
+			for (std::size_t level = 1; level < levels; ++level)
+			{
+				T const* const previous{ _Values.data() + _Offsets[level - 1] };
+				T* const current{ _Values.data() + _Offsets[level] };
+				std::size_t const half{ std::size_t{ 1 } << (level - 1) };
+				std::size_t const count{ _Size - 2 * half + 1 };
+				for (std::size_t i = 0; i < count; ++i)
+					current[i] = _Compare(previous[i + half], previous[i]) ? previous[i + half] : previous[i];
+			}
+		}
+
+		[[no_unique_address]] Compare _Compare{};
+		std::size_t _Size{ 0 };
+		std::vector<T> _Values;
+		std::vector<std::size_t> _Offsets;
+	};
+
+	//Block decomposition for huge arrays: a sparse table over the best value of each block of 64, and a scan for
+	//the partial blocks at both ends of a query (contiguous and vectorizable). The index adds about
+	//log2(n / 64) / 64 values per element; built from a span it refers to the caller's data instead of copying it.
+	template<typename T, typename Compare = std::less<>>
+	class BlockRangeQuery
+	{
+	public:
+		static constexpr std::size_t BlockSize{ 64 };
+
+		BlockRangeQuery() = default;
+
+		//The values must outlive the index
+		explicit BlockRangeQuery(std::span<T const> const values, Compare compare = {})
+			: _Compare{ std::move(compare) }, _Values{ values }
+		{
+			Build();
+		}
+
+		template<std::ranges::input_range R, typename Projection = std::identity>
+			requires std::regular_invocable<Projection&, std::ranges::range_reference_t<R>>
+		BlockRangeQuery(R&& range, Projection projection = {}, Compare compare = {})
+			: _Compare{ std::move(compare) }, _Owned{ Detail::Project<T>(std::forward<R>(range), projection) }, _Values{ _Owned }
+		{
+			Build();
+		}
+
+		//_Values may point into _Owned
+		BlockRangeQuery(BlockRangeQuery const&) = delete;
+		BlockRangeQuery& operator=(BlockRangeQuery const&) = delete;
+		BlockRangeQuery(BlockRangeQuery&&) noexcept = default;
+		BlockRangeQuery& operator=(BlockRangeQuery&&) noexcept = default;
+
+		std::size_t Size() const noexcept { return _Values.size(); }
+
+		//Memory of the index without the values themselves
+		std::size_t IndexByteSize() const noexcept { return _Blocks.ByteSize(); }
+
+		//Best value of [first, last); throws std::out_of_range for an empty or invalid range
+		T Query(std::size_t const first, std::size_t const last) const
+		{
+			Detail::CheckRange(first, last, _Values.size());
+			std::size_t const firstBlock{ first / BlockSize };
+			std::size_t const lastBlock{ (last - 1) / BlockSize };
+			if (firstBlock == lastBlock)
+				return Scan(first, last);
+			T best{ Scan(first, (firstBlock + 1) * BlockSize) };
+			T const tail{ Scan(lastBlock * BlockSize, last) };
+			if (_Compare(tail, best))
+				best = tail;
+			if (lastBlock > firstBlock + 1)
+			{
+				T const middle{ _Blocks.Query(firstBlock + 1, lastBlock) };
+				if (_Compare(middle, best))
+					best = middle;
+			}
+			return best;
+		}
+
+	private:
+		//Eight independent accumulators: no long dependency chain, and for arithmetic values the compiler turns each
+		//group of eight into one vector min/max
+		T Scan(std::size_t const first, std::size_t const last) const
+		{
+			constexpr std::size_t Lanes{ 8 };
+			T const* const values{ _Values.data() };
+			std::array<T, Lanes> best;
+			best.fill(values[first]);
+			std::size_t i{ first + 1 };
+			for (; i + Lanes <= last; i += Lanes)
+				for (std::size_t lane = 0; lane < Lanes; ++lane)
+					best[lane] = _Compare(values[i + lane], best[lane]) ? values[i + lane] : best[lane];
+			for (; i < last; ++i)
+				best[0] = _Compare(values[i], best[0]) ? values[i] : best[0];
+			for (std::size_t lane = 1; lane < Lanes; ++lane)
+				best[0] = _Compare(best[lane], best[0]) ? best[lane] : best[0];
+			return best[0];
+		}
+
+		void Build()
+		{
+			std::size_t const blocks{ (_Values.size() + BlockSize - 1) / BlockSize };
+			std::vector<T> best;
+			best.reserve(blocks);
+			for (std::size_t block = 0; block < blocks; ++block)
+				best.push_back(Scan(block * BlockSize, std::min(_Values.size(), (block + 1) * BlockSize)));
+			_Blocks = SparseTable<T, Compare>{ std::move(best), _Compare };
+		}
+
+		[[no_unique_address]] Compare _Compare{};
+		std::vector<T> _Owned;
+		std::span<T const> _Values;
+		SparseTable<T, Compare> _Blocks;
+	};
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "pch.h"
+#include "RangeQuery.h"
+
+//Dynamic prefix aggregates: range sums over values that keep changing, e.g. the total price of the products
+//ranked 100 to 2000 in a price-sorted catalog. Both trees build in O(n) and answer a query or apply an update in O(log n);
+//a batch of updates is applied level by level (segment tree) or with one O(n) rebuild when it is large (Fenwick tree).
+
+namespace RangeQueries
+{
+	//Update of one position, used by the batch paths
+	template<typename T>
+	struct PointUpdate
+	{
+		std::size_t Index;
+		T Value;
+	};
+
+	//Fenwick tree over blocks: the values are kept as they are, and a Fenwick tree holds the sums of blocks of 16 values.
+	//The tree is 16 times smaller than a plain Fenwick tree, so its upper levels stay cached, and the rest of a prefix
+	//is a short contiguous sum. T needs + and - (prices, counts).
+	template<typename T>
+	class FenwickTree
+	{
+	public:
+		static constexpr std::size_t BlockSize{ 16 };
+
+		FenwickTree() = default;
+
+		explicit FenwickTree(std::vector<T> values)
+			: _Values{ std::move(values) }
+		{
+			Build();
+		}
+
+		template<std::ranges::input_range R, typename Projection = std::identity>
+			requires std::regular_invocable<Projection&, std::ranges::range_reference_t<R>>
+		FenwickTree(R&& range, Projection projection = {})
+			: FenwickTree(Detail::Project<T>(std::forward<R>(range), projection))
+		{
+		}
+
+		std::size_t Size() const noexcept { return _Values.size(); }
+		T Value(std::size_t const index) const { return _Values.at(index); }
+
+		void Add(std::size_t const index, T const delta)
+		{
+			if (index >= _Values.size())
+				throw std::out_of_range{ "FenwickTree: index out of range" };
+			_Values[index] += delta;
+			for (std::size_t node = index / BlockSize + 1; node < _Tree.size(); node += node & (~node + 1))
+				_Tree[node] += delta;
+		}
+
+		void Set(std::size_t const index, T const value) { Add(index, value - Value(index)); }
+
+		//Sum of the first count values
+		T PrefixSum(std::size_t const count) const
+		{
+			if (count > _Values.size())
+				throw std::out_of_range{ "FenwickTree: count out of range" };
+			std::size_t const block{ count / BlockSize };
+			T sum{};
+			for (std::size_t node = block; node > 0; node &= node - 1)
+				sum += _Tree[node];
+			for (std::size_t i = block * BlockSize; i < count; ++i)
+				sum += _Values[i];
+			return sum;
+		}
+
+		//Sum of the values in [first, last)
+		T RangeSum(std::size_t const first, std::size_t const last) const
+		{
+			if (first > last)
+				throw std::out_of_range{ "FenwickTree: invalid range" };
+			return PrefixSum(last) - PrefixSum(first);
+		}
+
+		//Many Set operations at once: single updates for a small batch, otherwise one O(n) rebuild
+		void Set(std::span<PointUpdate<T> const> const updates)
+		{
+			for (auto const& update : updates)
+				if (update.Index >= _Values.size())
+					throw std::out_of_range{ "FenwickTree: index out of range" };
+			if (updates.size() * static_cast<std::size_t>(std::bit_width(_Tree.size())) < _Tree.size())
+			{
+				for (auto const& update : updates)
+					Set(update.Index, update.Value);
+				return;
+			}
+			for (auto const& update : updates)
+				_Values[update.Index] = update.Value;
+			Build();
+		}
+
+	private:
+		//Block sums, then every node passes its sum on to its parent: O(n)
+		void Build()
+		{
+			std::size_t const blocks{ (_Values.size() + BlockSize - 1) / BlockSize };
+			_Tree.assign(blocks + 1, T{});
+			for (std::size_t i = 0; i < _Values.size(); ++i)
+				_Tree[i / BlockSize + 1] += _Values[i];
+			for (std::size_t node = 1; node <= blocks; ++node)
+			{
+				std::size_t const parent{ node + (node & (~node + 1)) };
+				if (parent <= blocks)
+					_Tree[parent] += _Tree[node];
+			}
+		}
+
+		std::vector<T> _Values;
+		std::vector<T> _Tree;	//1-based Fenwick tree over the block sums
+	};
+
+	//Segment tree in Eytzinger (heap) order: node k has the children 2k and 2k + 1, the leaves are nodes [capacity, 2 * capacity).
+	//Queries and updates walk bottom-up without recursion; the upper levels share the first cache lines.
+	//Op must be associative with the identity T{} (std::plus<> for sums).
+	template<typename T, typename Op = std::plus<>>
+	class SegmentTree
+	{
+	public:
+		SegmentTree() = default;
+
+		explicit SegmentTree(std::vector<T> const& values, Op op = {})
+			: _Op{ std::move(op) }, _Size{ values.size() }, _Capacity{ std::bit_ceil(std::max<std::size_t>(values.size(), 1)) }
+		{
+			_Nodes.assign(2 * _Capacity, T{});
+			std::ranges::copy(values, _Nodes.begin() + static_cast<std::ptrdiff_t>(_Capacity));
+			BuildInnerNodes();
+		}
+
+		template<std::ranges::input_range R, typename Projection = std::identity>
+			requires std::regular_invocable<Projection&, std::ranges::range_reference_t<R>>
+		SegmentTree(R&& range, Projection projection = {}, Op op = {})
+			: SegmentTree(Detail::Project<T>(std::forward<R>(range), projection), std::move(op))
+		{
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+		T const& Value(std::size_t const index) const { return _Nodes[Leaf(index)]; }
+
+		void Set(std::size_t const index, T const value)
+		{
+			std::size_t node{ Leaf(index) };
+			_Nodes[node] = value;
+			for (node /= 2; node > 0; node /= 2)
+				_Nodes[node] = _Op(_Nodes[2 * node], _Nodes[2 * node + 1]);
+		}
+
+		//Op over the values in [first, last), T{} for an empty range
+		T Query(std::size_t first, std::size_t last) const
+		{
+			if (first > last or last > _Size)
+				throw std::out_of_range{ "SegmentTree: invalid range" };
+			T left{};
+			T right{};
+			for (first += _Capacity, last += _Capacity; first < last; first /= 2, last /= 2)
+			{
+				if (first & 1)
+					left = _Op(left, _Nodes[first++]);
+				if (last & 1)
+					right = _Op(_Nodes[--last], right);
+			}
+			return _Op(left, right);
+		}
+
+		//Many Set operations at once: the leaves are written first, then each level recomputes only the parents that changed.
+		//A large batch recomputes all inner nodes in O(n) instead.
+		void Set(std::span<PointUpdate<T> const> const updates)
+		{
+			std::vector<std::size_t> dirty;
+			dirty.reserve(updates.size());
+			for (auto const& update : updates)
+				dirty.push_back(Leaf(update.Index) / 2);
+			for (auto const& update : updates)
+				_Nodes[_Capacity + update.Index] = update.Value;
+			if (updates.size() * static_cast<std::size_t>(std::bit_width(_Capacity)) >= _Capacity)
+			{
+				BuildInnerNodes();
+				return;
+			}
+			std::ranges::sort(dirty);
+			dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+			while (not dirty.empty() and dirty.front() > 0)
+			{
+				std::size_t kept{ 0 };
+				for (auto const node : dirty)
+				{
+					_Nodes[node] = _Op(_Nodes[2 * node], _Nodes[2 * node + 1]);
+					if (kept == 0 or dirty[kept - 1] != node / 2)
+						dirty[kept++] = node / 2;
+				}
+				dirty.resize(kept);
+			}
+		}
+
+	private:
+		void BuildInnerNodes()
+		{
+			for (std::size_t node = _Capacity; node-- > 1;)
+				_Nodes[node] = _Op(_Nodes[2 * node], _Nodes[2 * node + 1]);
+		}
+
+		std::size_t Leaf(std::size_t const index) const
+		{
+			if (index >= _Size)
+				throw std::out_of_range{ "SegmentTree: index out of range" };
+			return _Capacity + index;
+		}
+
+		[[no_unique_address]] Op _Op{};
+		std::size_t _Size{ 0 };
+		std::size_t _Capacity{ 0 };
+		std::vector<T> _Nodes;
+	};
+}
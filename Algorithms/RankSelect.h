@@ -0,0 +1,180 @@
+#pragma once
+
+#include "pch.h"
+#include "Bits.h"
+
+//Rank/select bitvector with a poppy-style directory: how many set bits lie before position i (rank, O(1)) and
+//where the k-th set bit is (select, O(log n)), e.g. over the FreeDelivery() column of a product catalog.
+//One 64 bit directory entry per 2048 bits holds the count before it (32 bits) and the counts of the first three of its
+//four 512 bit blocks (10 bits each); a 64 bit count per 2^32 bits extends that to any size. Select samples the superblock
+//of every 8192nd set bit and binary searches between two samples. Directory and samples take under 3.6% of the bits.
+
+namespace Succinct
+{
+	class RankSelect
+	{
+	public:
+		static constexpr std::size_t BlockBits{ 512 };
+		static constexpr std::size_t SuperblockBits{ 2048 };
+		static constexpr std::size_t SelectSampling{ 8192 };
+
+		RankSelect()
+			: RankSelect(std::vector<std::uint64_t>{}, 0)
+		{
+		}
+
+		//Bits in 64 bit words, bit i in word i / 64 at position i % 64 (the layout of Bits.h)
+		RankSelect(std::vector<std::uint64_t> words, std::size_t const size)
+			: _Words{ std::move(words) }, _Size{ size }
+		{
+			if (_Words.size() < Bits::WordCount(size))
+				throw std::length_error{ "RankSelect: fewer words than bits" };
+			Build();
+		}
+
+		//One bit per element: projection(element), e.g. { catalog, &Product::FreeDelivery }
+		template<std::ranges::input_range R, typename Projection = std::identity>
+			requires std::predicate<Projection&, std::ranges::range_reference_t<R>>
+		RankSelect(R&& range, Projection projection = {})
+		{
+			std::size_t size{ 0 };
+			for (auto&& element : range)
+			{
+				if (size % 64 == 0)
+					_Words.push_back(0);
+				_Words.back() |= std::uint64_t{ static_cast<bool>(std::invoke(projection, element)) } << (size % 64);
+				++size;
+			}
+			_Size = size;
+			Build();
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+		std::size_t Count() const noexcept { return _Count; }
+		bool Get(std::size_t const position) const noexcept { return Bits::Get(_Words, position); }
+
+		//Memory of directory and samples, without the bits themselves
+		std::size_t OverheadBytes() const noexcept
+		{
+			return (_Directory.size() + _Chunks.size()) * sizeof(std::uint64_t) + _Samples.size() * sizeof(std::uint32_t);
+		}
+
+		//Number of set bits in [0, position)
+		std::size_t Rank1(std::size_t const position) const
+		{
+			if (position > _Size)
+				throw std::out_of_range{ "RankSelect: position out of range" };
+			std::size_t const superblock{ position / SuperblockBits };
+			std::uint64_t const entry{ _Directory[superblock] };
+			std::size_t rank{ RankBefore(superblock) };
+			std::size_t const block{ (position / BlockBits) % 4 };
+			for (std::size_t i = 0; i < block; ++i)
+				rank += BlockCount(entry, i);
+			std::size_t const word{ position / 64 };
+			for (std::size_t i = word & ~std::size_t{ 7 }; i < word; ++i)
+				rank += static_cast<std::size_t>(std::popcount(_Words[i]));
+			return rank + static_cast<std::size_t>(std::popcount(_Words[word] & Bits::LowMask(position % 64)));
+		}
+
+		std::size_t Rank0(std::size_t const position) const { return position - Rank1(position); }
+
+		//Number of set bits in [first, last)
+		std::size_t Count(std::size_t const first, std::size_t const last) const
+		{
+			if (first > last)
+				throw std::out_of_range{ "RankSelect: invalid range" };
+			return Rank1(last) - Rank1(first);
+		}
+
+		//Position of the set bit with the given rank (0-based): Rank1(Select1(k)) == k and Get(Select1(k))
+		std::size_t Select1(std::size_t rank) const
+		{
+			if (rank >= _Count)
+				throw std::out_of_range{ "RankSelect: rank out of range" };
+			//Last superblock in the sampled interval with fewer than rank + 1 set bits before it
+			std::size_t low{ _Samples[rank / SelectSampling] };
+			std::size_t high{ _Samples[rank / SelectSampling + 1] };
+			while (low < high)
+			{
+				std::size_t const middle{ (low + high + 1) / 2 };
+				if (RankBefore(middle) <= rank)
+					low = middle;
+				else
+					high = middle - 1;
+			}
+			rank -= RankBefore(low);
+
+			std::uint64_t const entry{ _Directory[low] };
+			std::size_t block{ 0 };
+			for (; block < 3 and rank >= BlockCount(entry, block); ++block)
+				rank -= BlockCount(entry, block);
+			std::size_t word{ low * (SuperblockBits / 64) + block * (BlockBits / 64) };
+			for (auto count = static_cast<std::size_t>(std::popcount(_Words[word])); rank >= count; count = static_cast<std::size_t>(std::popcount(_Words[word])))
+			{
+				rank -= count;
+				++word;
+			}
+			return word * 64 + Bits::SelectInWord(_Words[word], static_cast<unsigned>(rank));
+		}
+
+	private:
+		static constexpr std::size_t ChunkBits{ std::size_t{ 1 } << 32 };
+
+		static std::size_t BlockCount(std::uint64_t const entry, std::size_t const block) noexcept
+		{
+			return static_cast<std::size_t>((entry >> (32 + 10 * block)) & 0x3FF);
+		}
+
+		std::size_t RankBefore(std::size_t const superblock) const noexcept
+		{
+			return static_cast<std::size_t>(_Chunks[superblock * SuperblockBits / ChunkBits] + (_Directory[superblock] & 0xFFFF'FFFF));
+		}
+
+		//The words are padded to whole superblocks plus one, so that Rank1(Size()) needs no special case
+		void Build()
+		{
+			std::size_t const superblocks{ _Size / SuperblockBits + 1 };
+			constexpr std::size_t WordsPerSuperblock{ SuperblockBits / 64 };
+			_Words.resize(superblocks * WordsPerSuperblock, 0);
+			if (_Size % 64 != 0)
+				_Words[_Size / 64] &= Bits::LowMask(_Size % 64);
+			std::fill(_Words.begin() + static_cast<std::ptrdiff_t>(Bits::WordCount(_Size)), _Words.end(), 0);
+
+			_Directory.assign(superblocks, 0);
+			_Chunks.clear();
+			_Samples.clear();
+			std::uint64_t total{ 0 };
+			std::uint64_t chunkStart{ 0 };
+			for (std::size_t superblock = 0; superblock < superblocks; ++superblock)
+			{
+				if (superblock * SuperblockBits % ChunkBits == 0)
+				{
+					_Chunks.push_back(total);
+					chunkStart = total;
+				}
+				std::uint64_t entry{ total - chunkStart };
+				for (std::size_t block = 0; block < 4; ++block)
+				{
+					std::uint64_t count{ 0 };
+					for (std::size_t i = 0; i < BlockBits / 64; ++i)
+						count += static_cast<std::uint64_t>(std::popcount(_Words[superblock * WordsPerSuperblock + block * (BlockBits / 64) + i]));
+					if (block < 3)
+						entry |= count << (32 + 10 * block);
+					total += count;
+				}
+				_Directory[superblock] = entry;
+				while (_Samples.size() * SelectSampling < total)
+					_Samples.push_back(static_cast<std::uint32_t>(superblock));
+			}
+			_Samples.push_back(static_cast<std::uint32_t>(superblocks - 1));
+			_Count = static_cast<std::size_t>(total);
+		}
+
+		std::vector<std::uint64_t> _Words;
+		std::size_t _Size{ 0 };
+		std::size_t _Count{ 0 };
+		std::vector<std::uint64_t> _Directory;	//per superblock: set bits before it within its chunk | three 10 bit block counts
+		std::vector<std::uint64_t> _Chunks;		//set bits before each 2^32 bit chunk
+		std::vector<std::uint32_t> _Samples;	//superblock of every SelectSampling-th set bit, then the last superblock
+	};
+}
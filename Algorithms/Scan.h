@@ -0,0 +1,196 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "Parallel.h"
+
+//Prefix sum (scan) primitives for arbitrary associative operations.
+//int32 additions over contiguous memory use an AVX2 in-register scan, the parallel versions use reduce-then-scan.
+
+namespace Scan
+{
+	namespace Detail
+	{
+		template<typename InIt, typename OutIt, typename Op>
+		concept SimdAddable = Traits::ContiguousIterator<InIt> and Traits::ContiguousIterator<OutIt>
+			and std::same_as<std::iter_value_t<InIt>, std::iter_value_t<OutIt>>
+			and std::integral<std::iter_value_t<InIt>> and sizeof(std::iter_value_t<InIt>) == 4
+			and (std::same_as<Op, std::plus<>> or std::same_as<Op, std::plus<std::iter_value_t<InIt>>>);
+
+#if defined(__AVX2__)
+		//Scan of 8 int32 lanes: log-step shifts within each 128 bit lane, then the low lane's total is added to the high lane
+		inline __m256i ScanLanes(__m256i x) noexcept
+		{
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+			__m256i const lowTotal{ _mm256_permute2x128_si256(_mm256_shuffle_epi32(x, 0xFF), _mm256_shuffle_epi32(x, 0xFF), 0x08) };
+			return _mm256_add_epi32(x, lowTotal);
+		}
+#endif
+
+		//Inclusive (or exclusive) running sum of count int32 values starting with carry; returns the total
+		template<bool Exclusive, typename T>
+		T AddScan(T const* input, T* output, std::size_t const count, T carry) noexcept
+		{
+			std::size_t i{ 0 };
+#if defined(__AVX2__)
+			__m256i carryLanes{ _mm256_set1_epi32(static_cast<int>(carry)) };
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i const x{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + i)) };
+				__m256i const inclusive{ _mm256_add_epi32(ScanLanes(x), carryLanes) };
+				__m256i const result{ Exclusive ? _mm256_sub_epi32(inclusive, x) : inclusive };
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), result);
+				carryLanes = _mm256_permutevar8x32_epi32(inclusive, _mm256_set1_epi32(7));
+			}
+			carry = static_cast<T>(_mm256_cvtsi256_si32(carryLanes));
+#endif
+			for (; i < count; ++i)
+			{
+				T const x{ input[i] }; //read before write: input and output may be the same
+				output[i] = Exclusive ? carry : static_cast<T>(carry + x);
+				carry = static_cast<T>(carry + x);
+			}
+			return carry;
+		}
+	}
+
+	//Same as std::inclusive_scan(first, last, out, op, init)
+	template<std::input_iterator InIt, typename OutIt, typename Op, typename T>
+	OutIt InclusiveScan(InIt first, InIt last, OutIt out, Op op, T init)
+	{
+		if constexpr (Detail::SimdAddable<InIt, OutIt, Op>)
+		{
+			auto const count{ static_cast<std::size_t>(last - first) };
+			using V = std::iter_value_t<InIt>;
+			Detail::AddScan<false>(std::to_address(first), std::to_address(out), count, static_cast<V>(init));
+			return out + count;
+		}
+		else
+		{
+			for (; first != last; ++first, ++out)
+			{
+				init = op(std::move(init), *first);
+				*out = init;
+			}
+			return out;
+		}
+	}
+
+	//Same as std::inclusive_scan(first, last, out, op)
+	template<std::input_iterator InIt, typename OutIt, typename Op = std::plus<>>
+	OutIt InclusiveScan(InIt first, InIt last, OutIt out, Op op = {})
+	{
+		if (first == last)
+			return out;
+		if constexpr (Detail::SimdAddable<InIt, OutIt, Op>)
+		{
+			return InclusiveScan(first, last, out, op, std::iter_value_t<InIt>{ 0 });
+		}
+		else
+		{
+			std::iter_value_t<InIt> init{ *first };
+			*out = init;
+			return InclusiveScan(++first, last, ++out, op, std::move(init));
+		}
+	}
+
+	//Same as std::exclusive_scan(first, last, out, init, op)
+	template<std::input_iterator InIt, typename OutIt, typename T, typename Op = std::plus<>>
+	OutIt ExclusiveScan(InIt first, InIt last, OutIt out, T init, Op op = {})
+	{
+		if constexpr (Detail::SimdAddable<InIt, OutIt, Op>)
+		{
+			auto const count{ static_cast<std::size_t>(last - first) };
+			using V = std::iter_value_t<InIt>;
+			Detail::AddScan<true>(std::to_address(first), std::to_address(out), count, static_cast<V>(init));
+			return out + count;
+		}
+		else
+		{
+			for (; first != last; ++first, ++out)
+			{
+				T next{ op(init, *first) }; //compute before writing: first and out may be the same
+				*out = std::move(init);
+				init = std::move(next);
+			}
+			return out;
+		}
+	}
+
+	namespace Detail
+	{
+		//Pass 1 of reduce-then-scan: the total of each partition
+		template<typename It, typename Op>
+		std::vector<std::iter_value_t<It>> ReducePartitions(It first, std::size_t const count, Op op, unsigned const partitions)
+		{
+			std::vector<std::iter_value_t<It>> totals(partitions);
+			Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+				totals[index] = std::accumulate(first + range.Begin + 1, first + range.End, first[range.Begin], op);
+			}, partitions);
+			return totals;
+		}
+	}
+
+	//Multi-threaded inclusive scan (reduce-then-scan): each thread reduces its partition,
+	//the partition totals are scanned, then each thread scans its partition starting with its offset
+	template<std::random_access_iterator InIt, std::random_access_iterator OutIt, typename Op = std::plus<>>
+	OutIt ParallelInclusiveScan(InIt first, InIt last, OutIt out, Op op = {}, unsigned const threads = Parallel::ThreadCount())
+	{
+		auto const count{ static_cast<std::size_t>(last - first) };
+		unsigned const partitions{ Parallel::PartitionCount(count, threads) };
+		if (partitions == 1 or count == 0)
+			return InclusiveScan(first, last, out, op);
+		auto totals{ Detail::ReducePartitions(first, count, op, partitions) };
+		InclusiveScan(totals.begin(), totals.end(), totals.begin(), op);
+		Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+			if (index == 0)
+				InclusiveScan(first + range.Begin, first + range.End, out + range.Begin, op);
+			else
+				InclusiveScan(first + range.Begin, first + range.End, out + range.Begin, op, totals[index - 1]);
+		}, partitions);
+		return out + count;
+	}
+
+	//Multi-threaded exclusive scan (reduce-then-scan)
+	template<std::random_access_iterator InIt, std::random_access_iterator OutIt, typename T, typename Op = std::plus<>>
+	OutIt ParallelExclusiveScan(InIt first, InIt last, OutIt out, T init, Op op = {}, unsigned const threads = Parallel::ThreadCount())
+	{
+		auto const count{ static_cast<std::size_t>(last - first) };
+		unsigned const partitions{ Parallel::PartitionCount(count, threads) };
+		if (partitions == 1 or count == 0)
+			return ExclusiveScan(first, last, out, init, op);
+		auto const totals{ Detail::ReducePartitions(first, count, op, partitions) };
+		std::vector<T> offsets(partitions);
+		ExclusiveScan(totals.begin(), totals.end(), offsets.begin(), init, op);
+		Parallel::ForEachPartition(count, [&](unsigned const index, Parallel::Range const range) {
+			ExclusiveScan(first + range.Begin, first + range.End, out + range.Begin, offsets[index], op);
+		}, partitions);
+		return out + count;
+	}
+
+	//Order-preserving parallel copy_if (Exercise2): the exclusive scan of the predicate flags gives every kept element its output offset.
+	//The offsets are 32 bit (half the memory traffic of size_t), so at most 2^32 - 1 elements are supported.
+	template<std::ranges::random_access_range R, typename Predicate>
+	std::vector<std::ranges::range_value_t<R>> ParallelCopyIf(R const& range, Predicate predicate, unsigned const threads = Parallel::ThreadCount())
+	{
+		auto const first{ std::ranges::begin(range) };
+		auto const count{ static_cast<std::size_t>(std::ranges::size(range)) };
+		if (count > std::numeric_limits<std::uint32_t>::max())
+			throw std::length_error{ "ParallelCopyIf: too many elements" };
+		std::vector<std::uint32_t> offsets(count);
+		Parallel::ForEachPartition(count, [&](unsigned, Parallel::Range const r) {
+			for (std::size_t i = r.Begin; i < r.End; ++i)
+				offsets[i] = predicate(first[i]) ? 1 : 0;
+		}, threads);
+		std::uint32_t const lastFlag{ count > 0 ? offsets.back() : 0u };
+		ParallelExclusiveScan(offsets.begin(), offsets.end(), offsets.begin(), std::uint32_t{ 0 }, std::plus<>{}, threads);
+		std::vector<std::ranges::range_value_t<R>> result(count > 0 ? offsets.back() + lastFlag : 0);
+		Parallel::ForEachPartition(count, [&](unsigned, Parallel::Range const r) {
+			for (std::size_t i = r.Begin; i < r.End; ++i)
+				if (i + 1 < count ? offsets[i + 1] != offsets[i] : lastFlag != 0)
+					result[offsets[i]] = first[i];
+		}, threads);
+		return result;
+	}
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "Hash.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Search index over a sorted vector in Eytzinger (breadth-first) layout: the first levels of the implicit search tree
+//share cache lines, so a lower bound query touches far fewer lines than a binary search (Misc::BinarySearch).
+//A built index can be saved in a versioned file format and memory-mapped on the next start instead of being rebuilt.
+
+namespace Indexes
+{
+	//Layout of an index file: this header, then the keys and the ranks, each starting at a 64 byte boundary
+	struct IndexFileHeader
+	{
+		static constexpr std::array<char, 8> ExpectedMagic{ 'L', 'S', 'T', 'L', 'I', 'D', 'X', '\0' };
+		static constexpr std::uint32_t CurrentVersion{ 1 };
+		static constexpr std::uint32_t EytzingerLayout{ 1 };
+
+		std::array<char, 8> Magic{ ExpectedMagic };
+		std::uint32_t Version{ CurrentVersion };
+		std::uint32_t Layout{ EytzingerLayout };
+		std::uint32_t KeySize{ 0 };
+		std::uint32_t KeyKind{ 0 };			//0 unsigned integer, 1 signed integer, 2 floating point
+		std::uint64_t Count{ 0 };			//number of keys in the source data
+		std::uint64_t SourceHash{ 0 };		//hash of the sorted source data the index was built from
+		std::uint64_t KeysOffset{ 0 };
+		std::uint64_t RanksOffset{ 0 };
+		std::uint64_t PayloadChecksum{ 0 };	//hash of keys and ranks
+	};
+
+	//Hash of the source data, stored in the index file to detect a stale index
+	template<typename T>
+	std::uint64_t SourceHash(std::span<T const> const data) noexcept
+	{
+		return Hashing::HashBytes(std::string_view{ reinterpret_cast<char const*>(data.data()), data.size_bytes() });
+	}
+
+	namespace Detail
+	{
+		//Read-only memory mapping of a whole file (Linux); elsewhere the file is read into memory
+		class MappedFile
+		{
+		public:
+			explicit MappedFile(std::filesystem::path const& path)
+			{
+#if defined(__linux__)
+				int const fd{ ::open(path.c_str(), O_RDONLY) };
+				if (fd < 0)
+					throw std::runtime_error{ std::format("Indexes: cannot open {}", path.string()) };
+				struct stat status {};
+				::fstat(fd, &status);
+				_Size = static_cast<std::size_t>(status.st_size);
+				void* memory{ _Size > 0 ? ::mmap(nullptr, _Size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED };
+				::close(fd);
+				if (memory == MAP_FAILED)
+					throw std::runtime_error{ std::format("Indexes: cannot map {}", path.string()) };
+				_Data = static_cast<std::byte const*>(memory);
+#else
+				std::ifstream file{ path, std::ios::binary };
+				if (not file)
+					throw std::runtime_error{ std::format("Indexes: cannot open {}", path.string()) };
+				_Size = static_cast<std::size_t>(std::filesystem::file_size(path));
+				_Copy.resize((_Size + 63) / 64);
+				file.read(reinterpret_cast<char*>(_Copy.data()), static_cast<std::streamsize>(_Size));
+				_Data = reinterpret_cast<std::byte const*>(_Copy.data());
+#endif
+			}
+
+			~MappedFile()
+			{
+#if defined(__linux__)
+				if (_Data != nullptr)
+					::munmap(const_cast<std::byte*>(_Data), _Size);
+#endif
+			}
+
+			MappedFile(MappedFile const&) = delete;
+			MappedFile& operator=(MappedFile const&) = delete;
+
+			std::span<std::byte const> Bytes() const noexcept { return { _Data, _Size }; }
+
+		private:
+			std::byte const* _Data{ nullptr };
+			std::size_t _Size{ 0 };
+#if !defined(__linux__)
+			struct alignas(64) Line { std::byte Bytes[64]; };
+			std::vector<Line> _Copy;
+#endif
+		};
+
+		inline std::uint64_t AlignTo64(std::uint64_t const offset) noexcept
+		{
+			return (offset + 63) / 64 * 64;
+		}
+	}
+
+	template<Traits::ArithmeticKey T>
+	class EytzingerIndex
+	{
+	public:
+		//Build from sorted data
+		explicit EytzingerIndex(std::span<T const> const sorted)
+		{
+			assert(std::ranges::is_sorted(sorted));
+			if (sorted.size() >= std::numeric_limits<std::uint32_t>::max())
+				throw std::length_error{ "EytzingerIndex: too many keys" };
+			_OwnedKeys.resize(sorted.size() + 1); //1-based: node k has the children 2k and 2k + 1
+			_OwnedRanks.resize(sorted.size() + 1);
+			std::size_t next{ 0 };
+			Fill(sorted, 1, next);
+			_Keys = _OwnedKeys;
+			_Ranks = _OwnedRanks;
+			_Count = sorted.size();
+			_SourceHash = SourceHash(sorted);
+		}
+
+		//_Keys and _Ranks may point into _OwnedKeys and _OwnedRanks, which a copy would not carry along
+		EytzingerIndex(EytzingerIndex const&) = delete;
+		EytzingerIndex& operator=(EytzingerIndex const&) = delete;
+		EytzingerIndex(EytzingerIndex&&) noexcept = default;
+		EytzingerIndex& operator=(EytzingerIndex&&) noexcept = default;
+
+		//Map a saved index. Throws std::runtime_error if the file is not a valid index for T.
+		//verifyChecksum re-hashes the payload (O(n)); the header checks alone are O(1).
+		static EytzingerIndex Load(std::filesystem::path const& path, bool const verifyChecksum = false)
+		{
+			EytzingerIndex index;
+			index._File = std::make_shared<Detail::MappedFile>(path);
+			auto const bytes{ index._File->Bytes() };
+			IndexFileHeader header;
+			if (bytes.size() < sizeof(header))
+				throw std::runtime_error{ std::format("Indexes: {} is too small for an index", path.string()) };
+			std::memcpy(&header, bytes.data(), sizeof(header));
+			if (header.Magic != IndexFileHeader::ExpectedMagic)
+				throw std::runtime_error{ std::format("Indexes: {} is not an index file", path.string()) };
+			if (header.Version != IndexFileHeader::CurrentVersion or header.Layout != IndexFileHeader::EytzingerLayout)
+				throw std::runtime_error{ std::format("Indexes: {} has unsupported version {} / layout {}", path.string(), header.Version, header.Layout) };
+			if (header.KeySize != sizeof(T) or header.KeyKind != KeyKind())
+				throw std::runtime_error{ std::format("Indexes: {} was built for another key type", path.string()) };
+			//The header is untrusted: compare by division, so that no sum or product can wrap around
+			auto const fits = [&bytes](std::uint64_t const offset, std::uint64_t const count, std::size_t const size) {
+				return offset <= bytes.size() and count <= (bytes.size() - offset) / size;
+			};
+			if (header.Count >= bytes.size() or header.KeysOffset % 64 != 0 or header.RanksOffset % 64 != 0)
+				throw std::runtime_error{ std::format("Indexes: {} is truncated", path.string()) };
+			std::uint64_t const entries{ header.Count + 1 };
+			if (not fits(header.KeysOffset, entries, sizeof(T)) or not fits(header.RanksOffset, entries, sizeof(std::uint32_t)))
+				throw std::runtime_error{ std::format("Indexes: {} is truncated", path.string()) };
+
+			index._Count = static_cast<std::size_t>(header.Count);
+			index._SourceHash = header.SourceHash;
+			index._Keys = { reinterpret_cast<T const*>(bytes.data() + header.KeysOffset), static_cast<std::size_t>(entries) };
+			index._Ranks = { reinterpret_cast<std::uint32_t const*>(bytes.data() + header.RanksOffset), static_cast<std::size_t>(entries) };
+			if (verifyChecksum and index.PayloadChecksum() != header.PayloadChecksum)
+				throw std::runtime_error{ std::format("Indexes: checksum mismatch in {}", path.string()) };
+			return index;
+		}
+
+		void Save(std::filesystem::path const& path) const
+		{
+			IndexFileHeader header;
+			header.KeySize = sizeof(T);
+			header.KeyKind = KeyKind();
+			header.Count = _Count;
+			header.SourceHash = _SourceHash;
+			header.KeysOffset = Detail::AlignTo64(sizeof(header));
+			header.RanksOffset = Detail::AlignTo64(header.KeysOffset + _Keys.size_bytes());
+			header.PayloadChecksum = PayloadChecksum();
+
+			std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+			auto const writeAt = [&file](std::uint64_t const offset, void const* data, std::size_t const size) {
+				static constexpr std::array<char, 64> zeros{};
+				file.write(zeros.data(), static_cast<std::streamsize>(offset - static_cast<std::uint64_t>(file.tellp())));
+				file.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+			};
+			writeAt(0, &header, sizeof(header));
+			writeAt(header.KeysOffset, _Keys.data(), _Keys.size_bytes());
+			writeAt(header.RanksOffset, _Ranks.data(), _Ranks.size_bytes());
+			if (not file.flush())
+				throw std::runtime_error{ std::format("Indexes: cannot write {}", path.string()) };
+		}
+
+		//True if the index was built from exactly this data
+		bool Matches(std::span<T const> const sorted) const noexcept
+		{
+			return sorted.size() == _Count and SourceHash(sorted) == _SourceHash;
+		}
+
+		//Index of the first element >= value in the source data, or Size() if there is none (Misc::BinarySearch semantics)
+		std::size_t LowerBound(T const value) const noexcept
+		{
+			std::size_t k{ 1 };
+			std::size_t const n{ _Count };
+			while (k <= n)
+			{
+#if defined(__GNUC__) || defined(__clang__)
+				__builtin_prefetch(_Keys.data() + std::min(16 * k, n)); //the great-great-grandchildren share one cache line
+#endif
+				k = 2 * k + (_Keys[k] < value);
+			}
+			k >>= std::countr_one(k) + 1; //undo the right turns after the last left turn
+			return k == 0 ? n : _Ranks[k];
+		}
+
+		std::size_t Size() const noexcept { return _Count; }
+
+	private:
+		EytzingerIndex() = default;
+
+		static constexpr std::uint32_t KeyKind() noexcept
+		{
+			return std::floating_point<T> ? 2 : (std::signed_integral<T> ? 1 : 0);
+		}
+
+		//In-order traversal of the implicit tree assigns the sorted keys
+		void Fill(std::span<T const> const sorted, std::size_t const k, std::size_t& next)
+		{
+			if (k > sorted.size())
+				return;
+			Fill(sorted, 2 * k, next);
+			_OwnedKeys[k] = sorted[next];
+			_OwnedRanks[k] = static_cast<std::uint32_t>(next++);
+			Fill(sorted, 2 * k + 1, next);
+		}
+
+		std::uint64_t PayloadChecksum() const noexcept
+		{
+			return Hashing::HashBytes(std::string_view{ reinterpret_cast<char const*>(_Keys.data()), _Keys.size_bytes() },
+				Hashing::HashBytes(std::string_view{ reinterpret_cast<char const*>(_Ranks.data()), _Ranks.size_bytes() }));
+		}
+
+		std::vector<T> _OwnedKeys;
+		std::vector<std::uint32_t> _OwnedRanks;
+		std::shared_ptr<Detail::MappedFile> _File;
+		std::span<T const> _Keys;
+		std::span<std::uint32_t const> _Ranks;
+		std::size_t _Count{ 0 };
+		std::uint64_t _SourceHash{ 0 };
+	};
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "pch.h"
+#include "Bits.h"
+
+//Packed form of the marker lists of Exercise11/12 ("-", "#", "#3", "-18"):
+//one selection bit and one has-value bit per element plus a parallel array of values,
+//instead of one std::string (32 bytes) per element.
+
+namespace Containers
+{
+	class SelectionList
+	{
+	public:
+		SelectionList() = default;
+
+		//Parse marker strings: '#' = selected, '-' = not selected, optionally followed by a number
+		explicit SelectionList(std::vector<std::string> const& markers)
+		{
+			for (auto const& marker : markers)
+			{
+				assert(not marker.empty() and (marker[0] == '#' or marker[0] == '-'));
+				std::optional<std::int32_t> value;
+				if (marker.size() > 1)
+				{
+					std::int32_t number{ 0 };
+					[[maybe_unused]] auto const [end, error] { std::from_chars(marker.data() + 1, marker.data() + marker.size(), number) };
+					assert(error == std::errc{});
+					value = number;
+				}
+				PushBack(marker[0] == '#', value);
+			}
+		}
+
+		//The marker strings for Print/PrintTable
+		std::vector<std::string> ToStrings() const
+		{
+			std::vector<std::string> markers;
+			markers.reserve(_Size);
+			for (std::size_t i = 0; i < _Size; ++i)
+				markers.push_back(ToString(i));
+			return markers;
+		}
+
+		std::string ToString(std::size_t const index) const
+		{
+			std::string marker{ IsSelected(index) ? "#" : "-" };
+			if (HasValue(index))
+				marker += std::to_string(_Values[index]);
+			return marker;
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+		bool IsSelected(std::size_t const index) const noexcept { return Bits::Get(_Selected, index); }
+		bool HasValue(std::size_t const index) const noexcept { return Bits::Get(_HasValue, index); }
+		std::int32_t Value(std::size_t const index) const noexcept { return _Values[index]; }
+
+		void Select(std::size_t const index, bool const selected) noexcept
+		{
+			Bits::Set(_Selected, index, selected);
+		}
+
+		void PushBack(bool const selected, std::optional<std::int32_t> const value = std::nullopt)
+		{
+			if (_Size % 64 == 0)
+			{
+				_Selected.push_back(0);
+				_HasValue.push_back(0);
+			}
+			Bits::Set(_Selected, _Size, selected);
+			Bits::Set(_HasValue, _Size, value.has_value());
+			_Values.push_back(value.value_or(0));
+			++_Size;
+		}
+
+		//Bytes used per element
+		double BytesPerElement() const noexcept
+		{
+			return _Size == 0 ? 0.0 : static_cast<double>((_Selected.size() + _HasValue.size()) * sizeof(std::uint64_t) + _Values.size() * sizeof(std::int32_t)) / _Size;
+		}
+
+		//Move the count elements starting at first so that they start at newFirst (Exercise11).
+		//The other elements keep their relative order.
+		void MoveRange(std::size_t const first, std::size_t const count, std::size_t const newFirst)
+		{
+			assert(first + count <= _Size and newFirst + count <= _Size);
+			if (newFirst < first)
+				Rotate(newFirst, first, first + count);
+			else if (newFirst > first)
+				Rotate(first, first + count, newFirst + count);
+		}
+
+		//Stable partition of [first, last) by selection (Exercise12): selected elements first if selectedFirst,
+		//otherwise last. Works on 64 elements per step: the selection word is the gather mask.
+		void StablePartition(std::size_t const first, std::size_t const last, bool const selectedFirst)
+		{
+			assert(first <= last and last <= _Size);
+			std::size_t const count{ last - first };
+			std::vector<std::int32_t> selectedValues;
+			std::vector<std::int32_t> otherValues;
+			selectedValues.reserve(count);
+			otherValues.reserve(count);
+			std::vector<std::uint64_t> selectedHasValue(Bits::WordCount(count));
+			std::vector<std::uint64_t> otherHasValue(Bits::WordCount(count));
+
+			for (std::size_t position = first; position < last; position += 64)
+			{
+				unsigned const step{ static_cast<unsigned>(std::min<std::size_t>(last - position, 64)) };
+				std::uint64_t const selected{ Bits::Read(_Selected, position, step) };
+				std::uint64_t const other{ ~selected & Bits::LowMask(step) };
+				std::uint64_t const hasValue{ Bits::Read(_HasValue, position, step) };
+
+				Bits::Write(selectedHasValue, selectedValues.size(), Bits::ParallelExtract(hasValue, selected), std::popcount(selected));
+				Bits::Write(otherHasValue, otherValues.size(), Bits::ParallelExtract(hasValue, other), std::popcount(other));
+				std::int32_t const* values{ _Values.data() + position };
+				for (std::uint64_t mask = selected; mask != 0; mask &= mask - 1)
+					selectedValues.push_back(values[std::countr_zero(mask)]);
+				for (std::uint64_t mask = other; mask != 0; mask &= mask - 1)
+					otherValues.push_back(values[std::countr_zero(mask)]);
+			}
+
+			//Write back the two groups: the selection bits become one run of ones and one run of zeros
+			auto const writeGroup = [this](std::size_t position, std::vector<std::int32_t> const& values, std::vector<std::uint64_t> const& hasValue, bool const selected) {
+				std::copy(values.begin(), values.end(), _Values.begin() + position);
+				Bits::Copy(hasValue, 0, _HasValue, position, values.size());
+				for (std::size_t remaining = values.size(); remaining > 0; )
+				{
+					unsigned const step{ static_cast<unsigned>(std::min<std::size_t>(remaining, 64)) };
+					Bits::Write(_Selected, position, selected ? ~std::uint64_t{ 0 } : 0, step);
+					position += step;
+					remaining -= step;
+				}
+			};
+			if (selectedFirst)
+			{
+				writeGroup(first, selectedValues, selectedHasValue, true);
+				writeGroup(first + selectedValues.size(), otherValues, otherHasValue, false);
+			}
+			else
+			{
+				writeGroup(first, otherValues, otherHasValue, false);
+				writeGroup(first + otherValues.size(), selectedValues, selectedHasValue, true);
+			}
+		}
+
+	private:
+		//std::rotate over all three arrays: bit copies for the bitmaps and memmove for the values
+		void Rotate(std::size_t const first, std::size_t const middle, std::size_t const last)
+		{
+			Bits::Rotate(_Selected, first, middle, last);
+			Bits::Rotate(_HasValue, first, middle, last);
+			std::int32_t* values{ _Values.data() };
+			std::vector<std::int32_t> const head(values + first, values + middle);
+			std::memmove(values + first, values + middle, (last - middle) * sizeof(std::int32_t));
+			std::copy(head.begin(), head.end(), values + first + (last - middle));
+		}
+
+		std::vector<std::uint64_t> _Selected;
+		std::vector<std::uint64_t> _HasValue;
+		std::vector<std::int32_t> _Values;
+		std::size_t _Size{ 0 };
+	};
+}
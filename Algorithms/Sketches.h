@@ -0,0 +1,166 @@
+#pragma once
+
+#include "pch.h"
+#include "Hash.h"
+
+//Fixed-memory summaries of unbounded streams. Both sketches are mergeable:
+//every thread can fill its own sketch and the sketches are combined afterwards.
+
+namespace Sketches
+{
+	//Approximate number of distinct values.
+	//With m = 2^Precision registers the relative standard error is 1.04 / sqrt(m),
+	//e.g. 0.81% for the default Precision 14, which needs 16 KiB.
+	template<unsigned Precision = 14>
+	class HyperLogLog
+	{
+		static_assert(Precision >= 4 and Precision <= 18, "HyperLogLog precision must be in [4, 18]");
+
+	public:
+		static constexpr std::size_t RegisterCount{ std::size_t{ 1 } << Precision };
+
+		HyperLogLog() : _Registers(RegisterCount) {}
+
+		//Add a value by its 64 bit hash: the low bits pick the register, the register keeps the longest run of leading zeros
+		void AddHash(std::uint64_t const hash) noexcept
+		{
+			std::size_t const index{ static_cast<std::size_t>(hash & (RegisterCount - 1)) };
+			std::uint64_t const rest{ hash >> Precision };
+			auto const rank{ static_cast<std::uint8_t>(std::countl_zero(rest) - Precision + 1) };
+			_Registers[index] = std::max(_Registers[index], rank);
+		}
+
+		template<typename T>
+		void Add(T const& value) noexcept
+		{
+			AddHash(Hashing::Hash(value));
+		}
+
+		template<typename T>
+		void AddRange(std::span<T const> const values) noexcept
+		{
+			for (T const& value : values)
+				Add(value);
+		}
+
+		//Combine with another sketch: the register-wise maximum (32 registers per AVX2 instruction)
+		void Merge(HyperLogLog const& other) noexcept
+		{
+			std::size_t i{ 0 };
+#if defined(__AVX2__)
+			for (; i + 32 <= RegisterCount; i += 32)
+			{
+				__m256i const a{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_Registers.data() + i)) };
+				__m256i const b{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(other._Registers.data() + i)) };
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(_Registers.data() + i), _mm256_max_epu8(a, b));
+			}
+#endif
+			for (; i < RegisterCount; ++i)
+				_Registers[i] = std::max(_Registers[i], other._Registers[i]);
+		}
+
+		//Estimated number of distinct values added so far
+		double Estimate() const noexcept
+		{
+			double const m{ static_cast<double>(RegisterCount) };
+			double sum{ 0 };
+			std::size_t zeros{ 0 };
+			for (std::uint8_t const r : _Registers)
+			{
+				sum += std::ldexp(1.0, -r);
+				zeros += (r == 0);
+			}
+			double const alpha{ 0.7213 / (1.0 + 1.079 / m) };
+			double const estimate{ alpha * m * m / sum };
+			if (estimate <= 2.5 * m and zeros > 0)
+				return m * std::log(m / static_cast<double>(zeros)); //small range correction (linear counting)
+			return estimate;
+		}
+
+		//Relative standard error of Estimate()
+		static double StandardError() noexcept
+		{
+			return 1.04 / std::sqrt(static_cast<double>(RegisterCount));
+		}
+
+		void Clear() noexcept
+		{
+			std::ranges::fill(_Registers, std::uint8_t{ 0 });
+		}
+
+	private:
+		std::vector<std::uint8_t> _Registers;
+	};
+
+	//Approximate frequency of each value.
+	//Estimate(x) never underestimates, and with probability 1 - delta it overestimates by at most epsilon * TotalCount(),
+	//where width = ceil(e / epsilon) and depth = ceil(ln(1 / delta)).
+	class CountMinSketch
+	{
+	public:
+		CountMinSketch(std::size_t const width, std::size_t const depth)
+			: _Width{ std::max<std::size_t>(width, 1) }, _Depth{ std::max<std::size_t>(depth, 1) }, _Counters(_Width * _Depth)
+		{
+		}
+
+		//Sketch for the given error bound: overestimate <= epsilon * TotalCount() with probability 1 - delta
+		static CountMinSketch FromErrorBounds(double const epsilon, double const delta)
+		{
+			return CountMinSketch{ static_cast<std::size_t>(std::ceil(std::numbers::e / epsilon)), static_cast<std::size_t>(std::ceil(std::log(1.0 / delta))) };
+		}
+
+		template<typename T>
+		void Add(T const& value, std::uint64_t const count = 1) noexcept
+		{
+			std::uint64_t const hash{ Hashing::Hash(value) };
+			for (std::size_t row = 0; row < _Depth; ++row)
+				_Counters[CounterIndex(hash, row)] += count;
+			_Total += count;
+		}
+
+		template<typename T>
+		void AddRange(std::span<T const> const values) noexcept
+		{
+			for (T const& value : values)
+				Add(value);
+		}
+
+		//Estimated number of times value was added: the minimum over all rows
+		template<typename T>
+		std::uint64_t Estimate(T const& value) const noexcept
+		{
+			std::uint64_t estimate{ std::numeric_limits<std::uint64_t>::max() };
+			std::uint64_t const hash{ Hashing::Hash(value) };
+			for (std::size_t row = 0; row < _Depth; ++row)
+				estimate = std::min(estimate, _Counters[CounterIndex(hash, row)]);
+			return estimate;
+		}
+
+		//Combine with a sketch of the same dimensions: the counters are added
+		void Merge(CountMinSketch const& other)
+		{
+			if (other._Width != _Width or other._Depth != _Depth)
+				throw std::invalid_argument{ "CountMinSketch::Merge: sketches have different dimensions" };
+			std::transform(_Counters.begin(), _Counters.end(), other._Counters.begin(), _Counters.begin(), std::plus<>{});
+			_Total += other._Total;
+		}
+
+		std::uint64_t TotalCount() const noexcept { return _Total; }
+		std::size_t Width() const noexcept { return _Width; }
+		std::size_t Depth() const noexcept { return _Depth; }
+
+	private:
+		//Row i uses the hash h1 + i * h2 (double hashing), so one 64 bit hash serves all rows
+		std::size_t CounterIndex(std::uint64_t const hash, std::size_t const row) const noexcept
+		{
+			std::uint64_t const h1{ hash & 0xFFFFFFFF };
+			std::uint64_t const h2{ (hash >> 32) | 1 };
+			return row * _Width + static_cast<std::size_t>((h1 + row * h2) % _Width);
+		}
+
+		std::size_t _Width;
+		std::size_t _Depth;
+		std::vector<std::uint64_t> _Counters;
+		std::uint64_t _Total{ 0 };
+	};
+}
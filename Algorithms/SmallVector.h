@@ -0,0 +1,465 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "FastAlgorithms.h"
+
+//Vector with inline storage for N elements. It only allocates once it holds more than N elements,
+//so tiny per-request vectors (like the ones in the exercises) cost no heap allocation at all.
+
+namespace Containers
+{
+	template<typename T, std::size_t N, typename Allocator = std::allocator<T>>
+	class SmallVector
+	{
+		static_assert(N > 0, "SmallVector needs room for at least one inline element");
+		using AllocatorTraits = std::allocator_traits<Allocator>;
+
+	public:
+		using value_type = T;
+		using allocator_type = Allocator;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using const_reference = T const&;
+		using pointer = T*;
+		using const_pointer = T const*;
+		using iterator = T*;
+		using const_iterator = T const*;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		static constexpr size_type InlineCapacity{ N };
+
+		SmallVector() noexcept(noexcept(Allocator())) = default;
+		explicit SmallVector(Allocator const& allocator) noexcept : _Allocator{ allocator } {}
+		explicit SmallVector(size_type const count, Allocator const& allocator = Allocator()) : _Allocator{ allocator }
+		{
+			resize(count);
+		}
+		SmallVector(size_type const count, T const& value, Allocator const& allocator = Allocator()) : _Allocator{ allocator }
+		{
+			assign(count, value);
+		}
+		template<std::input_iterator InputIt>
+		SmallVector(InputIt first, InputIt last, Allocator const& allocator = Allocator()) : _Allocator{ allocator }
+		{
+			assign(first, last);
+		}
+		SmallVector(std::initializer_list<T> init, Allocator const& allocator = Allocator()) : _Allocator{ allocator }
+		{
+			assign(init.begin(), init.end());
+		}
+		SmallVector(SmallVector const& other)
+			: _Allocator{ AllocatorTraits::select_on_container_copy_construction(other._Allocator) }
+		{
+			assign(other.begin(), other.end());
+		}
+		SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : _Allocator{ other._Allocator }
+		{
+			TakeFrom(other);
+		}
+
+		~SmallVector()
+		{
+			clear();
+			Deallocate();
+		}
+
+		SmallVector& operator=(SmallVector const& other)
+		{
+			if (this != &other)
+				assign(other.begin(), other.end());
+			return *this;
+		}
+		SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (this != &other)
+			{
+				clear();
+				if (_Allocator == other._Allocator)
+				{
+					Deallocate();
+					TakeFrom(other);
+				}
+				else
+				{
+					assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+					other.clear();
+				}
+			}
+			return *this;
+		}
+		SmallVector& operator=(std::initializer_list<T> init)
+		{
+			assign(init.begin(), init.end());
+			return *this;
+		}
+
+		void assign(size_type const count, T const& value)
+		{
+			if (count > _Capacity)
+			{
+				SmallVector replacement(_Allocator);
+				replacement.Reallocate(count);
+				std::uninitialized_fill_n(replacement._Data, count, value);
+				replacement._Size = count;
+				*this = std::move(replacement);
+				return;
+			}
+			//value may be one of the elements
+			T const copy{ value };
+			clear();
+			std::uninitialized_fill_n(_Data, count, copy);
+			_Size = count;
+		}
+		template<std::input_iterator InputIt>
+		void assign(InputIt first, InputIt last)
+		{
+			clear();
+			if constexpr (std::forward_iterator<InputIt>)
+			{
+				auto const count{ static_cast<size_type>(std::distance(first, last)) };
+				reserve(count);
+				std::uninitialized_copy(first, last, _Data);
+				_Size = count;
+			}
+			else
+			{
+				for (; first != last; ++first)
+					emplace_back(*first);
+			}
+		}
+		void assign(std::initializer_list<T> init)
+		{
+			assign(init.begin(), init.end());
+		}
+
+		allocator_type get_allocator() const noexcept
+		{
+			return _Allocator;
+		}
+
+		//Element access
+		reference at(size_type const index)
+		{
+			if (index >= _Size)
+				throw std::out_of_range{ "SmallVector::at: index out of range" };
+			return _Data[index];
+		}
+		const_reference at(size_type const index) const
+		{
+			if (index >= _Size)
+				throw std::out_of_range{ "SmallVector::at: index out of range" };
+			return _Data[index];
+		}
+		reference operator[](size_type const index) noexcept { return _Data[index]; }
+		const_reference operator[](size_type const index) const noexcept { return _Data[index]; }
+		reference front() noexcept { return _Data[0]; }
+		const_reference front() const noexcept { return _Data[0]; }
+		reference back() noexcept { return _Data[_Size - 1]; }
+		const_reference back() const noexcept { return _Data[_Size - 1]; }
+		T* data() noexcept { return _Data; }
+		T const* data() const noexcept { return _Data; }
+
+		//Iterators
+		iterator begin() noexcept { return _Data; }
+		const_iterator begin() const noexcept { return _Data; }
+		const_iterator cbegin() const noexcept { return _Data; }
+		iterator end() noexcept { return _Data + _Size; }
+		const_iterator end() const noexcept { return _Data + _Size; }
+		const_iterator cend() const noexcept { return _Data + _Size; }
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+		const_reverse_iterator crend() const noexcept { return rend(); }
+
+		//Capacity
+		[[nodiscard]] bool empty() const noexcept { return _Size == 0; }
+		size_type size() const noexcept { return _Size; }
+		size_type max_size() const noexcept { return AllocatorTraits::max_size(_Allocator); }
+		size_type capacity() const noexcept { return _Capacity; }
+
+		//True while the elements live in the inline buffer
+		bool IsInline() const noexcept
+		{
+			return _Data == InlineData();
+		}
+
+		void reserve(size_type const newCapacity)
+		{
+			if (newCapacity > max_size())
+				throw std::length_error{ "SmallVector::reserve: capacity too large" };
+			if (newCapacity > _Capacity)
+				Reallocate(newCapacity);
+		}
+
+		void shrink_to_fit()
+		{
+			if (not IsInline() and _Size < _Capacity)
+				Reallocate(_Size);
+		}
+
+		//Modifiers
+		void clear() noexcept
+		{
+			std::destroy(_Data, _Data + _Size);
+			_Size = 0;
+		}
+
+		iterator insert(const_iterator position, T const& value) { return emplace(position, value); }
+		iterator insert(const_iterator position, T&& value) { return emplace(position, std::move(value)); }
+		iterator insert(const_iterator position, size_type const count, T const& value)
+		{
+			auto const index{ position - cbegin() };
+			T const copy{ value }; //value may refer to an element of this vector
+			GrowFor(_Size + count);
+			std::uninitialized_fill_n(end(), count, copy);
+			_Size += count;
+			std::rotate(begin() + index, end() - count, end());
+			return begin() + index;
+		}
+		template<std::input_iterator InputIt>
+		iterator insert(const_iterator position, InputIt first, InputIt last)
+		{
+			//Append at the end and rotate the new elements into place
+			auto const index{ position - cbegin() };
+			auto const oldSize{ _Size };
+			if constexpr (std::forward_iterator<InputIt>)
+			{
+				auto const count{ static_cast<size_type>(std::distance(first, last)) };
+				if (_Size + count > _Capacity)
+				{
+					SmallVector copy(first, last, _Allocator); //copy first: the source may be part of this vector
+					GrowFor(_Size + count);
+					std::uninitialized_move(copy.begin(), copy.end(), end());
+				}
+				else
+				{
+					std::uninitialized_copy(first, last, end());
+				}
+				_Size += count;
+			}
+			else
+			{
+				for (; first != last; ++first)
+					emplace_back(*first);
+			}
+			std::rotate(begin() + index, begin() + oldSize, end());
+			return begin() + index;
+		}
+		iterator insert(const_iterator position, std::initializer_list<T> init)
+		{
+			return insert(position, init.begin(), init.end());
+		}
+
+		template<typename... Args>
+		iterator emplace(const_iterator position, Args&&... args)
+		{
+			auto const index{ position - cbegin() };
+			if (position == cend())
+			{
+				emplace_back(std::forward<Args>(args)...);
+				return begin() + index;
+			}
+			T value(std::forward<Args>(args)...); //construct first: args may refer to an element of this vector
+			if (_Size == _Capacity)
+				Reallocate(2 * _Capacity);
+			std::construct_at(end(), std::move(back()));
+			std::move_backward(begin() + index, end() - 1, end());
+			++_Size;
+			_Data[index] = std::move(value);
+			return begin() + index;
+		}
+
+		iterator erase(const_iterator position)
+		{
+			return erase(position, position + 1);
+		}
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			auto const index{ first - cbegin() };
+			auto const count{ last - first };
+			if (count > 0)
+			{
+				std::move(begin() + index + count, end(), begin() + index);
+				std::destroy(end() - count, end());
+				_Size -= count;
+			}
+			return begin() + index;
+		}
+
+		void push_back(T const& value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+
+		template<typename... Args>
+		reference emplace_back(Args&&... args)
+		{
+			if (_Size == _Capacity)
+			{
+				//Construct the new element before moving the old ones: args may refer to one of them
+				size_type const newCapacity{ 2 * _Capacity };
+				T* newData{ AllocatorTraits::allocate(_Allocator, newCapacity) };
+				bool constructed{ false };
+				try
+				{
+					std::construct_at(newData + _Size, std::forward<Args>(args)...);
+					constructed = true;
+					RelocateTo(newData, newCapacity);
+				}
+				catch (...)
+				{
+					if (constructed)
+						std::destroy_at(newData + _Size);
+					AllocatorTraits::deallocate(_Allocator, newData, newCapacity);
+					throw;
+				}
+			}
+			else
+			{
+				std::construct_at(_Data + _Size, std::forward<Args>(args)...);
+			}
+			return _Data[_Size++];
+		}
+
+		void pop_back() noexcept
+		{
+			std::destroy_at(_Data + --_Size);
+		}
+
+		void resize(size_type const count)
+		{
+			if (count < _Size)
+			{
+				erase(begin() + count, end());
+				return;
+			}
+			GrowFor(count);
+			std::uninitialized_value_construct(end(), _Data + count);
+			_Size = count;
+		}
+		void resize(size_type const count, T const& value)
+		{
+			if (count < _Size)
+				erase(begin() + count, end());
+			else
+				insert(end(), count - _Size, value);
+		}
+
+		void swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			SmallVector temporary{ std::move(other) };
+			other = std::move(*this);
+			*this = std::move(temporary);
+		}
+
+		friend void swap(SmallVector& a, SmallVector& b) noexcept(noexcept(a.swap(b)))
+		{
+			a.swap(b);
+		}
+
+		friend bool operator==(SmallVector const& a, SmallVector const& b)
+		{
+			return std::equal(a.begin(), a.end(), b.begin(), b.end());
+		}
+
+		friend auto operator<=>(SmallVector const& a, SmallVector const& b) requires std::three_way_comparable<T>
+		{
+			return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+		}
+
+	private:
+		T* InlineData() noexcept { return reinterpret_cast<T*>(_Inline); }
+		T const* InlineData() const noexcept { return reinterpret_cast<T const*>(_Inline); }
+
+		//Move the elements into newData (capacity newCapacity) and release the old heap buffer.
+		//If a copy throws, nothing has changed and newData is still the caller's.
+		void RelocateTo(T* newData, size_type const newCapacity) noexcept(Traits::TriviallyRelocatable<T> or std::is_nothrow_move_constructible_v<T>)
+		{
+			if constexpr (Traits::TriviallyRelocatable<T> or std::is_nothrow_move_constructible_v<T>)
+			{
+				FastPath::Relocate(_Data, _Data + _Size, newData);
+			}
+			else
+			{
+				//Without a noexcept move, moving could leave both buffers half-filled; copy instead, as std::vector does
+				std::uninitialized_copy(_Data, _Data + _Size, newData);
+				std::destroy(_Data, _Data + _Size);
+			}
+			Deallocate();
+			_Data = newData;
+			_Capacity = newCapacity;
+		}
+
+		//Make room for size elements, growing geometrically like emplace_back so that repeated small growth stays amortized O(1)
+		void GrowFor(size_type const size)
+		{
+			if (size > _Capacity)
+				reserve(std::max(size, 2 * _Capacity));
+		}
+
+		//Move the elements into a buffer of newCapacity (the inline buffer if they fit)
+		void Reallocate(size_type const newCapacity)
+		{
+			if (newCapacity <= N)
+			{
+				if (not IsInline())
+				{
+					T* heapData{ _Data };
+					size_type const heapCapacity{ _Capacity };
+					FastPath::Relocate(heapData, heapData + _Size, InlineData());
+					AllocatorTraits::deallocate(_Allocator, heapData, heapCapacity);
+					_Data = InlineData();
+					_Capacity = N;
+				}
+				return;
+			}
+			T* newData{ AllocatorTraits::allocate(_Allocator, newCapacity) };
+			try
+			{
+				RelocateTo(newData, newCapacity);
+			}
+			catch (...)
+			{
+				AllocatorTraits::deallocate(_Allocator, newData, newCapacity);
+				throw;
+			}
+		}
+
+		void Deallocate() noexcept
+		{
+			if (not IsInline())
+				AllocatorTraits::deallocate(_Allocator, _Data, _Capacity);
+			_Data = InlineData();
+			_Capacity = N;
+		}
+
+		//Take over the elements of other (which must be empty of heap memory of its own afterwards); this is empty and inline
+		void TakeFrom(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (other.IsInline())
+			{
+				std::uninitialized_move(other._Data, other._Data + other._Size, _Data);
+				_Size = other._Size;
+				other.clear();
+			}
+			else
+			{
+				_Data = other._Data;
+				_Size = other._Size;
+				_Capacity = other._Capacity;
+				other._Data = other.InlineData();
+				other._Size = 0;
+				other._Capacity = N;
+			}
+		}
+
+		alignas(T) std::byte _Inline[N * sizeof(T)];
+		T* _Data{ InlineData() };
+		size_type _Size{ 0 };
+		size_type _Capacity{ N };
+		Allocator _Allocator{};
+	};
+}
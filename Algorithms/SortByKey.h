@@ -0,0 +1,191 @@
+#pragma once
+
+#include "pch.h"
+#include "Traits.h"
+#include "FastAlgorithms.h"
+#include "Permutation.h"
+
+//Decorate-sort-undecorate: the projection is evaluated once per element into a compact (key, index) array,
+//the array is sorted, and the elements are moved into the resulting order in one pass.
+//Sorting Products by Name() with a projection in std::ranges::sort calls Name() (a string copy) twice per comparison;
+//here it is called n times. All sorts in this file are stable.
+
+namespace FastPath
+{
+	namespace Detail
+	{
+		template<typename U>
+		struct KeyIndex
+		{
+			U Key;
+			std::uint32_t Index;
+		};
+
+		//Stable LSD radix sort of (key, index) pairs by key with 8 bit digits; small inputs use std::sort on (key, index)
+		template<typename U>
+		void RadixSortByKey(std::span<KeyIndex<U>> const items, std::vector<KeyIndex<U>>& buffer)
+		{
+			std::size_t const count{ items.size() };
+			if (count < RadixSortThreshold)
+			{
+				std::sort(items.begin(), items.end(), [](KeyIndex<U> const& a, KeyIndex<U> const& b) { return a.Key < b.Key or (a.Key == b.Key and a.Index < b.Index); });
+				return;
+			}
+			constexpr std::size_t Passes{ sizeof(U) };
+			std::array<std::array<std::size_t, 256>, Passes> histograms{};
+			for (auto const& item : items)
+				for (std::size_t pass = 0; pass < Passes; ++pass)
+					++histograms[pass][(item.Key >> (pass * 8)) & 0xFF];
+
+			buffer.resize(std::max(buffer.size(), count));
+			KeyIndex<U>* source{ items.data() };
+			KeyIndex<U>* target{ buffer.data() };
+			for (std::size_t pass = 0; pass < Passes; ++pass)
+			{
+				auto& histogram{ histograms[pass] };
+				if (histogram[(source[0].Key >> (pass * 8)) & 0xFF] == count)
+					continue; //all keys share this digit
+				std::exclusive_scan(histogram.begin(), histogram.end(), histogram.begin(), std::size_t{ 0 });
+				for (std::size_t i = 0; i < count; ++i)
+					target[histogram[(source[i].Key >> (pass * 8)) & 0xFF]++] = source[i];
+				std::swap(source, target);
+			}
+			if (source != items.data())
+				std::copy_n(source, count, items.data());
+		}
+
+		//8 bytes of text from offset on, big-endian and zero padded: compares like the bytes themselves
+		inline std::uint64_t StringChunk(std::string_view const text, std::size_t const offset) noexcept
+		{
+			std::uint64_t chunk{ 0 };
+			for (std::size_t i = offset; i < std::min(offset + 8, text.size()); ++i)
+				chunk |= std::uint64_t{ static_cast<std::uint8_t>(text[i]) } << (8 * (7 - (i - offset)));
+			return chunk;
+		}
+
+		//Bits that order like the key under <, so that radix sorting stays stable: -0.0 and 0.0 compare equal and keep
+		//their input order, and all NaNs (which < leaves unordered) become one quiet NaN, sorted after +infinity in input order
+		template<Traits::ArithmeticKey Key>
+		Traits::UnsignedKey<Key> StableKeyBits(Key key) noexcept
+		{
+			if constexpr (std::floating_point<Key>)
+			{
+				if (key == 0)
+					key = 0;
+				else if (std::isnan(key))
+					key = std::numeric_limits<Key>::quiet_NaN();
+			}
+			return Traits::ToOrderedBits(key);
+		}
+
+		//Sort items (all equal in the first offset bytes) by the next 8 byte chunk, then recurse into runs of equal chunks
+		template<typename Keys>
+		void SortStrings(std::span<KeyIndex<std::uint64_t>> const items, Keys const& keys, std::size_t const offset, std::vector<KeyIndex<std::uint64_t>>& buffer)
+		{
+			auto const full = [&keys](KeyIndex<std::uint64_t> const& a, KeyIndex<std::uint64_t> const& b) {
+				int const order{ std::string_view{ keys[a.Index] }.compare(keys[b.Index]) };
+				return order < 0 or (order == 0 and a.Index < b.Index);
+			};
+			if (items.size() < 32)
+			{
+				std::sort(items.begin(), items.end(), full);
+				return;
+			}
+			for (auto& item : items)
+				item.Key = StringChunk(keys[item.Index], offset);
+			RadixSortByKey(items, buffer);
+			for (std::size_t begin = 0; begin < items.size();)
+			{
+				std::size_t end{ begin + 1 };
+				bool longer{ std::string_view{ keys[items[begin].Index] }.size() > offset + 8 };
+				for (; end < items.size() and items[end].Key == items[begin].Key; ++end)
+					longer = longer and std::string_view{ keys[items[end].Index] }.size() > offset + 8;
+				if (end - begin > 1)
+				{
+					//Runs that contain a string ending in this chunk are decided by full comparisons (zero padding is ambiguous)
+					if (longer)
+						SortStrings(items.subspan(begin, end - begin), keys, offset + 8, buffer);
+					else
+						std::sort(items.begin() + static_cast<std::ptrdiff_t>(begin), items.begin() + static_cast<std::ptrdiff_t>(end), full);
+				}
+				begin = end;
+			}
+		}
+	}
+
+	//Stable order of the elements by projection(element): element order[i] belongs at position i.
+	//Arithmetic keys are radix sorted; strings are radix sorted by cached 8 byte chunks, with full comparisons only for ties.
+	template<std::ranges::random_access_range R, typename Projection>
+	std::vector<std::uint32_t> SortedOrder(R&& range, Projection projection)
+	{
+		using Result = std::invoke_result_t<Projection&, std::ranges::range_reference_t<R>>;
+		using Key = std::remove_cvref_t<Result>;
+		auto const count{ static_cast<std::size_t>(std::ranges::size(range)) };
+		if (count > std::numeric_limits<std::uint32_t>::max())
+			throw std::length_error{ "SortedOrder: too many elements" };
+		auto const first{ std::ranges::begin(range) };
+
+		std::vector<std::uint32_t> order(count);
+		if constexpr (Traits::ArithmeticKey<Key>)
+		{
+			using U = Traits::UnsignedKey<Key>;
+			std::vector<Detail::KeyIndex<U>> items(count);
+			for (std::size_t i = 0; i < count; ++i)
+				items[i] = { Detail::StableKeyBits(static_cast<Key>(std::invoke(projection, first[static_cast<std::ptrdiff_t>(i)]))), static_cast<std::uint32_t>(i) };
+			std::vector<Detail::KeyIndex<U>> buffer;
+			Detail::RadixSortByKey(std::span{ items }, buffer);
+			std::ranges::transform(items, order.begin(), &Detail::KeyIndex<U>::Index);
+		}
+		else if constexpr (std::convertible_to<Key const&, std::string_view>)
+		{
+			//A projection that returns a reference needs no copies: views into the elements will do
+			using Stored = std::conditional_t<std::is_lvalue_reference_v<Result>, std::string_view, Key>;
+			std::vector<Stored> keys;
+			keys.reserve(count);
+			for (std::size_t i = 0; i < count; ++i)
+				keys.emplace_back(std::invoke(projection, first[static_cast<std::ptrdiff_t>(i)]));
+			std::vector<Detail::KeyIndex<std::uint64_t>> items(count);
+			for (std::size_t i = 0; i < count; ++i)
+				items[i].Index = static_cast<std::uint32_t>(i);
+			std::vector<Detail::KeyIndex<std::uint64_t>> buffer;
+			Detail::SortStrings(std::span{ items }, keys, 0, buffer);
+			std::ranges::transform(items, order.begin(), &Detail::KeyIndex<std::uint64_t>::Index);
+		}
+		else
+		{
+			std::vector<std::pair<Key, std::uint32_t>> items;
+			items.reserve(count);
+			for (std::size_t i = 0; i < count; ++i)
+				items.emplace_back(std::invoke(projection, first[static_cast<std::ptrdiff_t>(i)]), static_cast<std::uint32_t>(i));
+			std::ranges::stable_sort(items, std::ranges::less{}, [](auto const& item) -> Key const& { return item.first; });
+			std::ranges::transform(items, order.begin(), &std::pair<Key, std::uint32_t>::second);
+		}
+		return order;
+	}
+
+	//Move the elements into order: afterwards position i holds the element that was at order[i]
+	template<std::ranges::random_access_range R>
+	void ApplyOrder(R&& range, std::span<std::uint32_t const> const order)
+	{
+		using T = std::ranges::range_value_t<R>;
+		if constexpr (std::same_as<std::remove_cvref_t<R>, std::vector<T>>)
+			Permutations::Gather(range, order);
+		else
+		{
+			auto const first{ std::ranges::begin(range) };
+			std::vector<T> gathered;
+			gathered.reserve(order.size());
+			for (auto const index : order)
+				gathered.push_back(std::move(first[static_cast<std::ptrdiff_t>(index)]));
+			std::ranges::move(gathered, first);
+		}
+	}
+
+	//Stable sort by projection(element), evaluating the projection once per element
+	template<std::ranges::random_access_range R, typename Projection>
+	void SortByKey(R&& range, Projection projection)
+	{
+		auto const order{ SortedOrder(range, std::move(projection)) };
+		ApplyOrder(std::forward<R>(range), order);
+	}
+}
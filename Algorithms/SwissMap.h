@@ -0,0 +1,359 @@
+#pragma once
+
+#include "pch.h"
+#include "Hash.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//Open addressing hash map in the style of Swiss tables: one control byte per slot holds 7 bits of the hash,
+//and 16 control bytes are compared in a single SSE2 instruction, so most probes touch one control group and one slot.
+//Lookups are heterogeneous: a SwissMap<std::string, T> can be searched with a std::string_view without allocating.
+
+namespace Containers
+{
+	namespace Detail
+	{
+		inline constexpr std::int8_t CtrlEmpty{ -128 };
+		inline constexpr std::int8_t CtrlDeleted{ -2 };
+		inline constexpr std::size_t GroupWidth{ 16 };
+
+		//16 control bytes; every query returns a mask with bit i set for a matching byte i
+		class ControlGroup
+		{
+		public:
+			explicit ControlGroup(std::int8_t const* ctrl) noexcept
+			{
+#if defined(__SSE2__) || defined(_M_X64)
+				_Ctrl = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ctrl));
+#else
+				std::memcpy(_Ctrl.data(), ctrl, GroupWidth);
+#endif
+			}
+
+			std::uint32_t Match(std::int8_t const h2) const noexcept
+			{
+#if defined(__SSE2__) || defined(_M_X64)
+				return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _Ctrl)));
+#else
+				std::uint32_t mask{ 0 };
+				for (std::size_t i = 0; i < GroupWidth; ++i)
+					mask |= static_cast<std::uint32_t>(_Ctrl[i] == h2) << i;
+				return mask;
+#endif
+			}
+
+			std::uint32_t MatchEmpty() const noexcept
+			{
+				return Match(CtrlEmpty);
+			}
+
+			//Empty and deleted are the only control bytes with the sign bit set
+			std::uint32_t MatchEmptyOrDeleted() const noexcept
+			{
+#if defined(__SSE2__) || defined(_M_X64)
+				return static_cast<std::uint32_t>(_mm_movemask_epi8(_Ctrl));
+#else
+				std::uint32_t mask{ 0 };
+				for (std::size_t i = 0; i < GroupWidth; ++i)
+					mask |= static_cast<std::uint32_t>(_Ctrl[i] < 0) << i;
+				return mask;
+#endif
+			}
+
+		private:
+#if defined(__SSE2__) || defined(_M_X64)
+			__m128i _Ctrl;
+#else
+			std::array<std::int8_t, GroupWidth> _Ctrl;
+#endif
+		};
+
+		//Control bytes of the empty map: every lookup ends in the first group without a table
+		alignas(GroupWidth) inline constexpr std::array<std::int8_t, GroupWidth> EmptyGroup{
+			CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty,
+			CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty };
+	}
+
+	template<typename Key, typename Value, typename Hash = Hashing::Hasher, typename KeyEqual = std::equal_to<>>
+	class SwissMap
+	{
+	public:
+		using Slot = std::pair<Key, Value>;
+
+		SwissMap() noexcept = default;
+
+		SwissMap(SwissMap const& other)
+			: _Hash{ other._Hash }, _Equal{ other._Equal }
+		{
+			try
+			{
+				Reserve(other._Size);
+				other.ForEach([this](Key const& key, Value const& value) { TryEmplace(key, value); });
+			}
+			catch (...)
+			{
+				Release(); //the destructor does not run for a constructor that throws
+				throw;
+			}
+		}
+
+		SwissMap(SwissMap&& other) noexcept
+		{
+			Swap(other);
+		}
+
+		SwissMap& operator=(SwissMap other) noexcept
+		{
+			Swap(other);
+			return *this;
+		}
+
+		~SwissMap()
+		{
+			Release();
+		}
+
+		void Swap(SwissMap& other) noexcept
+		{
+			std::swap(_Ctrl, other._Ctrl);
+			std::swap(_Slots, other._Slots);
+			std::swap(_Capacity, other._Capacity);
+			std::swap(_Size, other._Size);
+			std::swap(_GrowthLeft, other._GrowthLeft);
+			std::swap(_Hash, other._Hash);
+			std::swap(_Equal, other._Equal);
+		}
+
+		std::size_t Size() const noexcept { return _Size; }
+		bool Empty() const noexcept { return _Size == 0; }
+		std::size_t Capacity() const noexcept { return _Capacity; }
+
+		//Bytes of the control bytes and slots
+		std::size_t ByteSize() const noexcept
+		{
+			return _Capacity == 0 ? 0 : _Capacity + Detail::GroupWidth + _Capacity * sizeof(Slot);
+		}
+
+		//Make room for count elements without rehashing (maximum load factor 7/8)
+		void Reserve(std::size_t const count)
+		{
+			std::size_t const capacity{ std::bit_ceil(std::max(Detail::GroupWidth, count + count / 7 + 1)) };
+			if (capacity > _Capacity)
+				Rehash(capacity);
+		}
+
+		template<typename K>
+		Value* Find(K const& key) noexcept
+		{
+			std::size_t const index{ FindIndex(key, _Hash(key)) };
+			return index == NotFound ? nullptr : &_Slots[index].second;
+		}
+
+		template<typename K>
+		Value const* Find(K const& key) const noexcept
+		{
+			return const_cast<SwissMap*>(this)->Find(key);
+		}
+
+		template<typename K>
+		bool Contains(K const& key) const noexcept
+		{
+			return Find(key) != nullptr;
+		}
+
+		//Insert if the key is not present; returns the value and whether it was inserted
+		template<typename K, typename... Args>
+		std::pair<Value*, bool> TryEmplace(K&& key, Args&&... args)
+		{
+			std::uint64_t const hash{ _Hash(key) };
+			if (std::size_t const index{ FindIndex(key, hash) }; index != NotFound)
+				return { &_Slots[index].second, false };
+			std::size_t const index{ PrepareInsert(hash) };
+			//The slot is only marked full once its element exists: if the constructor throws, the table is unchanged
+			std::construct_at(_Slots + index, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+			_GrowthLeft -= _Ctrl[index] == Detail::CtrlEmpty;
+			SetCtrl(index, H2(hash));
+			++_Size;
+			return { &_Slots[index].second, true };
+		}
+
+		template<typename K, typename V>
+		std::pair<Value*, bool> InsertOrAssign(K&& key, V&& value)
+		{
+			auto const result{ TryEmplace(std::forward<K>(key), std::forward<V>(value)) };
+			if (not result.second)
+				*result.first = std::forward<V>(value);
+			return result;
+		}
+
+		//Bulk build: reserve once for the whole range, then insert each element under key(element)
+		template<std::ranges::input_range Range, typename KeyOf>
+		void InsertRange(Range&& values, KeyOf keyOf)
+		{
+			if constexpr (std::ranges::sized_range<Range>)
+				Reserve(_Size + std::ranges::size(values));
+			for (auto&& value : values)
+				TryEmplace(std::invoke(keyOf, value), std::forward<decltype(value)>(value));
+		}
+
+		//Erased slots become tombstones that lookups probe past; the next rehash drops them
+		template<typename K>
+		bool Erase(K const& key)
+		{
+			std::size_t const index{ FindIndex(key, _Hash(key)) };
+			if (index == NotFound)
+				return false;
+			std::destroy_at(_Slots + index);
+			SetCtrl(index, Detail::CtrlDeleted);
+			--_Size;
+			return true;
+		}
+
+		void Clear() noexcept
+		{
+			Release();
+			_Ctrl = const_cast<std::int8_t*>(Detail::EmptyGroup.data());
+			_Slots = nullptr;
+			_Capacity = _Size = _GrowthLeft = 0;
+		}
+
+		//fn(key, value) for every element in slot order
+		template<typename Fn>
+		void ForEach(Fn&& fn)
+		{
+			for (std::size_t i = 0; i < _Capacity; ++i)
+				if (_Ctrl[i] >= 0)
+					fn(std::as_const(_Slots[i].first), _Slots[i].second);
+		}
+
+		template<typename Fn>
+		void ForEach(Fn&& fn) const
+		{
+			for (std::size_t i = 0; i < _Capacity; ++i)
+				if (_Ctrl[i] >= 0)
+					fn(_Slots[i].first, std::as_const(_Slots[i].second));
+		}
+
+	private:
+		static constexpr std::size_t NotFound{ std::numeric_limits<std::size_t>::max() };
+
+		//The high bits choose where probing starts, the low 7 bits go into the control byte
+		static std::size_t H1(std::uint64_t const hash) noexcept { return static_cast<std::size_t>(hash >> 7); }
+		static std::int8_t H2(std::uint64_t const hash) noexcept { return static_cast<std::int8_t>(hash & 0x7F); }
+
+		//Probe group by group with growing steps (triangular numbers), which visits every group of a power of two table
+		template<typename K>
+		std::size_t FindIndex(K const& key, std::uint64_t const hash) const noexcept
+		{
+			std::size_t position{ H1(hash) & Mask() };
+			for (std::size_t step = Detail::GroupWidth;; step += Detail::GroupWidth)
+			{
+				Detail::ControlGroup const group{ _Ctrl + position };
+				for (std::uint32_t matches{ group.Match(H2(hash)) }; matches != 0; matches &= matches - 1)
+				{
+					std::size_t const index{ (position + static_cast<std::size_t>(std::countr_zero(matches))) & Mask() };
+					if (_Equal(_Slots[index].first, key))
+						return index;
+				}
+				if (group.MatchEmpty() != 0)
+					return NotFound;
+				position = (position + step) & Mask();
+			}
+		}
+
+		std::size_t FindFirstNonFull(std::uint64_t const hash) const noexcept
+		{
+			std::size_t position{ H1(hash) & Mask() };
+			for (std::size_t step = Detail::GroupWidth;; step += Detail::GroupWidth)
+			{
+				if (std::uint32_t const free{ Detail::ControlGroup{ _Ctrl + position }.MatchEmptyOrDeleted() }; free != 0)
+					return (position + static_cast<std::size_t>(std::countr_zero(free))) & Mask();
+				position = (position + step) & Mask();
+			}
+		}
+
+		//Find the slot for a new key; grows (or just drops tombstones) when only the last empty slots are left.
+		//The caller constructs the element and then marks the slot full.
+		std::size_t PrepareInsert(std::uint64_t const hash)
+		{
+			std::size_t const index{ _Capacity == 0 ? NotFound : FindFirstNonFull(hash) };
+			if (index == NotFound or (_GrowthLeft == 0 and _Ctrl[index] == Detail::CtrlEmpty))
+			{
+				Rehash(_Capacity == 0 or _Size * 16 > _Capacity * 7 ? std::max(Detail::GroupWidth, 2 * _Capacity) : _Capacity);
+				return FindFirstNonFull(hash);
+			}
+			return index;
+		}
+
+		//The first group is mirrored behind the table so a group load never wraps around
+		void SetCtrl(std::size_t const index, std::int8_t const value) noexcept
+		{
+			_Ctrl[index] = value;
+			if (index < Detail::GroupWidth)
+				_Ctrl[_Capacity + index] = value;
+		}
+
+		std::size_t Mask() const noexcept { return _Capacity == 0 ? 0 : _Capacity - 1; }
+
+		void Rehash(std::size_t const capacity)
+		{
+			auto* const oldCtrl{ _Ctrl };
+			auto* const oldSlots{ _Slots };
+			std::size_t const oldCapacity{ _Capacity };
+
+			//Allocate both arrays before changing anything, so that a failed allocation keeps the old table
+			auto* const ctrl{ new std::int8_t[capacity + Detail::GroupWidth] };
+			Slot* slots{ nullptr };
+			try
+			{
+				slots = std::allocator<Slot>{}.allocate(capacity);
+			}
+			catch (...)
+			{
+				delete[] ctrl;
+				throw;
+			}
+			std::fill_n(ctrl, capacity + Detail::GroupWidth, Detail::CtrlEmpty);
+			_Ctrl = ctrl;
+			_Slots = slots;
+			_Capacity = capacity;
+			_GrowthLeft = capacity - capacity / 8 - _Size;
+			for (std::size_t i = 0; i < oldCapacity; ++i)
+			{
+				if (oldCtrl[i] < 0)
+					continue;
+				std::uint64_t const hash{ _Hash(oldSlots[i].first) };
+				std::size_t const index{ FindFirstNonFull(hash) };
+				SetCtrl(index, H2(hash));
+				std::construct_at(_Slots + index, std::move(oldSlots[i]));
+				std::destroy_at(oldSlots + i);
+			}
+			if (oldCapacity > 0)
+			{
+				delete[] oldCtrl;
+				std::allocator<Slot>{}.deallocate(oldSlots, oldCapacity);
+			}
+		}
+
+		void Release() noexcept
+		{
+			if (_Capacity == 0)
+				return;
+			for (std::size_t i = 0; i < _Capacity; ++i)
+				if (_Ctrl[i] >= 0)
+					std::destroy_at(_Slots + i);
+			delete[] _Ctrl;
+			std::allocator<Slot>{}.deallocate(_Slots, _Capacity);
+		}
+
+		std::int8_t* _Ctrl{ const_cast<std::int8_t*>(Detail::EmptyGroup.data()) }; //never written while the capacity is 0
+		Slot* _Slots{ nullptr };
+		std::size_t _Capacity{ 0 };
+		std::size_t _Size{ 0 };
+		std::size_t _GrowthLeft{ 0 };
+		[[no_unique_address]] Hash _Hash;
+		[[no_unique_address]] KeyEqual _Equal;
+	};
+}
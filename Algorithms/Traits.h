@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pch.h"
+
+//Trait and concept layer used by the fast-path algorithms to pick a specialization at compile time
+
+namespace Traits
+{
+	//Trivially copyable types can be copied with memcpy/memmove
+	template<typename T>
+	concept TriviallyCopyable = std::is_trivially_copyable_v<T>;
+
+	//Customization point: specialize for types whose objects can be moved to new storage with memcpy
+	//(the source is then treated as dead without calling its destructor)
+	template<typename T>
+	struct IsTriviallyRelocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+	template<typename T>
+	concept TriviallyRelocatable = IsTriviallyRelocatable<std::remove_cv_t<T>>::value;
+
+	//Range whose elements lie consecutively in memory
+	template<typename R>
+	concept ContiguousRange = std::ranges::contiguous_range<R> and std::ranges::sized_range<R>;
+
+	//Iterator that points into contiguous memory
+	template<typename I>
+	concept ContiguousIterator = std::contiguous_iterator<I>;
+
+	//Keys that can be sorted by their bit pattern (radix sort) - integers and IEEE floats of 4 or 8 bytes
+	template<typename T>
+	concept ArithmeticKey = (std::integral<T> or std::floating_point<T>)
+		and not std::same_as<std::remove_cv_t<T>, bool>
+		and (sizeof(T) == 4 or sizeof(T) == 8);
+
+	//Unsigned integer with the same size as T
+	template<typename T>
+	using UnsignedKey = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+	//Map an arithmetic key to an unsigned integer with the same ordering
+	template<ArithmeticKey T>
+	constexpr UnsignedKey<T> ToOrderedBits(T value) noexcept
+	{
+		using U = UnsignedKey<T>;
+		constexpr U signBit{ U{ 1 } << (sizeof(T) * 8 - 1) };
+		U bits{ std::bit_cast<U>(value) };
+		if constexpr (std::floating_point<T>)
+			return (bits & signBit) ? ~bits : (bits | signBit); //negative floats: flip all bits, positive: flip sign
+		else if constexpr (std::signed_integral<T>)
+			return bits ^ signBit;
+		else
+			return bits;
+	}
+
+	//Inverse of ToOrderedBits
+	template<ArithmeticKey T>
+	constexpr T FromOrderedBits(UnsignedKey<T> bits) noexcept
+	{
+		using U = UnsignedKey<T>;
+		constexpr U signBit{ U{ 1 } << (sizeof(T) * 8 - 1) };
+		if constexpr (std::floating_point<T>)
+			bits = (bits & signBit) ? (bits ^ signBit) : ~bits;
+		else if constexpr (std::signed_integral<T>)
+			bits ^= signBit;
+		return std::bit_cast<T>(bits);
+	}
+}
@@ -0,0 +1,402 @@
+#pragma once
+
+#include "pch.h"
+#include "Bits.h"
+#include "Dedup.h"
+#include "FastAlgorithms.h"
+#include "SwissMap.h"
+
+//Trigram inverted index for substring search: every name is listed under each 3 byte substring it contains,
+//a query intersects the lists of its own trigrams and verifies the few candidates against the names.
+//Lists are compressed (deltas bit-packed in blocks of 128 ids) and intersected 8x8 ids at a time with AVX2.
+
+namespace Indexes
+{
+	//Sorted, unique ids in blocks of 128: the first id of a block is stored as is, the others as
+	//bit-packed gaps (gap - 1) with the smallest width that fits the block
+	class PostingList
+	{
+	public:
+		static constexpr std::size_t BlockSize{ 128 };
+
+		PostingList() = default;
+
+		explicit PostingList(std::span<std::uint32_t const> const ids)
+			: _Count{ ids.size() }
+		{
+			assert(std::ranges::adjacent_find(ids, std::greater_equal<>{}) == ids.end());
+			std::size_t bits{ 0 };
+			for (std::size_t begin = 0; begin < ids.size(); begin += BlockSize)
+			{
+				std::size_t const end{ std::min(begin + BlockSize, ids.size()) };
+				std::uint32_t widest{ 0 };
+				for (std::size_t i = begin + 1; i < end; ++i)
+					widest |= ids[i] - ids[i - 1] - 1;
+				auto const width{ static_cast<std::uint8_t>(std::bit_width(widest)) };
+				_BlockFirst.push_back(ids[begin]);
+				_BlockStart.push_back(bits);
+				_BlockBits.push_back(width);
+				bits += (end - begin - 1) * width;
+			}
+			_Packed.resize(Bits::WordCount(bits));
+			for (std::size_t block = 0; block < _BlockFirst.size(); ++block)
+			{
+				std::size_t position{ _BlockStart[block] };
+				std::size_t const begin{ block * BlockSize };
+				for (std::size_t i = begin + 1; i < std::min(begin + BlockSize, ids.size()); ++i, position += _BlockBits[block])
+					Bits::Write(_Packed, position, ids[i] - ids[i - 1] - 1, _BlockBits[block]);
+			}
+		}
+
+		std::size_t Size() const noexcept { return _Count; }
+
+		std::size_t ByteSize() const noexcept
+		{
+			return _BlockFirst.size() * (sizeof(std::uint32_t) + sizeof(std::uint64_t) + sizeof(std::uint8_t)) + _Packed.size() * sizeof(std::uint64_t);
+		}
+
+		//Decode one block into out (room for BlockSize ids); returns the number of ids
+		std::size_t DecodeBlock(std::size_t const block, std::uint32_t* out) const noexcept
+		{
+			std::size_t const count{ std::min(BlockSize, _Count - block * BlockSize) };
+			unsigned const width{ _BlockBits[block] };
+			std::size_t position{ _BlockStart[block] };
+			std::uint32_t id{ _BlockFirst[block] };
+			out[0] = id;
+			for (std::size_t i = 1; i < count; ++i, position += width)
+				out[i] = id += static_cast<std::uint32_t>(Bits::Read(_Packed, position, width)) + 1;
+			return count;
+		}
+
+		void Decode(std::vector<std::uint32_t>& out) const
+		{
+			out.resize(_Count);
+			for (std::size_t block = 0; block < _BlockFirst.size(); ++block)
+				DecodeBlock(block, out.data() + block * BlockSize);
+		}
+
+		//Ids that are in this list and in the sorted candidates. Only the blocks that can hold a candidate are decoded,
+		//which makes a short candidate list against a long posting list cost O(candidates) block decodes at most.
+		void IntersectSparse(std::span<std::uint32_t const> const candidates, std::vector<std::uint32_t>& out) const
+		{
+			out.clear();
+			std::array<std::uint32_t, BlockSize> decoded;
+			std::size_t decodedBlock{ _BlockFirst.size() };
+			std::size_t decodedCount{ 0 };
+			std::size_t block{ 0 };
+			for (auto const candidate : candidates)
+			{
+				//Last block whose first id <= candidate
+				block = static_cast<std::size_t>(std::upper_bound(_BlockFirst.begin() + static_cast<std::ptrdiff_t>(block), _BlockFirst.end(), candidate) - _BlockFirst.begin());
+				if (block == 0)
+					continue;
+				--block;
+				if (block != decodedBlock)
+				{
+					decodedCount = DecodeBlock(block, decoded.data());
+					decodedBlock = block;
+				}
+				if (std::binary_search(decoded.begin(), decoded.begin() + static_cast<std::ptrdiff_t>(decodedCount), candidate))
+					out.push_back(candidate);
+			}
+		}
+
+	private:
+		std::size_t _Count{ 0 };
+		std::vector<std::uint32_t> _BlockFirst;
+		std::vector<std::uint64_t> _BlockStart;	//bit position of the block's gaps in _Packed
+		std::vector<std::uint8_t> _BlockBits;
+		std::vector<std::uint64_t> _Packed;
+	};
+
+	//Intersection of two sorted, unique id lists. With AVX2, 8 ids of a are compared with all 8 ids of b
+	//(the 8 rotations of b) per step; the block with the smaller last id is consumed.
+	inline void Intersect(std::span<std::uint32_t const> const a, std::span<std::uint32_t const> const b, std::vector<std::uint32_t>& out)
+	{
+		out.resize(std::min(a.size(), b.size()) + 8); //room for a full 8 lane store
+		std::size_t i{ 0 };
+		std::size_t j{ 0 };
+		std::size_t count{ 0 };
+#if defined(__AVX2__)
+		__m256i rotations[7];
+		for (int r = 1; r < 8; ++r)
+			rotations[r - 1] = _mm256_setr_epi32(r % 8, (r + 1) % 8, (r + 2) % 8, (r + 3) % 8, (r + 4) % 8, (r + 5) % 8, (r + 6) % 8, (r + 7) % 8);
+		while (i + 8 <= a.size() and j + 8 <= b.size())
+		{
+			__m256i const va{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a.data() + i)) };
+			__m256i const vb{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b.data() + j)) };
+			__m256i matches{ _mm256_cmpeq_epi32(va, vb) };
+			for (auto const& rotation : rotations)
+				matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, rotation)));
+			auto const mask{ static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(matches))) };
+			__m256i const permutation{ _mm256_loadu_si256(reinterpret_cast<__m256i const*>(Dedup::Detail::CompactionTable[mask].data())) };
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data() + count), _mm256_permutevar8x32_epi32(va, permutation));
+			count += static_cast<std::size_t>(std::popcount(mask));
+			std::uint32_t const lastA{ a[i + 7] };
+			std::uint32_t const lastB{ b[j + 7] };
+			i += lastA <= lastB ? 8 : 0;
+			j += lastB <= lastA ? 8 : 0;
+		}
+#endif
+		while (i < a.size() and j < b.size())
+		{
+			if (a[i] < b[j])
+				++i;
+			else if (b[j] < a[i])
+				++j;
+			else
+			{
+				out[count++] = a[i];
+				++i;
+				++j;
+			}
+		}
+		out.resize(count);
+	}
+
+	class TrigramIndex
+	{
+	public:
+		TrigramIndex() = default;
+
+		//Bulk build: names[i] gets id i. All (trigram, id) pairs are radix sorted as 64 bit keys and cut into lists.
+		explicit TrigramIndex(std::span<std::string const> const names)
+		{
+			_Names.reserve(names.size());
+			std::vector<std::uint64_t> pairs;
+			std::vector<std::uint32_t> trigrams;
+			for (std::size_t id = 0; id < names.size(); ++id)
+			{
+				_Names.push_back(Fold(names[id]));
+				Trigrams(_Names.back(), trigrams);
+				for (auto const trigram : trigrams)
+					pairs.push_back(std::uint64_t{ trigram } << 32 | id);
+			}
+			_Live.assign(names.size(), 1);
+			_Renamed.assign(names.size(), 0);
+			_LiveCount = names.size();
+			FastPath::Sort(pairs);
+			std::vector<std::uint32_t> ids;
+			for (std::size_t begin = 0; begin < pairs.size();)
+			{
+				auto const trigram{ static_cast<std::uint32_t>(pairs[begin] >> 32) };
+				ids.clear();
+				std::size_t end{ begin };
+				for (; end < pairs.size() and static_cast<std::uint32_t>(pairs[end] >> 32) == trigram; ++end)
+					ids.push_back(static_cast<std::uint32_t>(pairs[end]));
+				_Postings.TryEmplace(trigram).first->Compressed = PostingList{ ids };
+				_CompressedCount += ids.size();
+				begin = end;
+			}
+		}
+
+		//Add a name under an id; an id that is already in use is replaced
+		void Add(std::uint32_t const id, std::string_view const name)
+		{
+			if (id < _Live.size() and _Live[id])
+				Remove(id);
+			if (id < _Names.size())
+				_Renamed[id] = 1; //the lists may still hold the trigrams of the previous name
+			else
+			{
+				_Names.resize(id + std::size_t{ 1 });
+				_Live.resize(id + std::size_t{ 1 });
+				_Renamed.resize(id + std::size_t{ 1 });
+			}
+			_Names[id] = Fold(name);
+			_Live[id] = 1;
+			++_LiveCount;
+			std::vector<std::uint32_t> trigrams;
+			Trigrams(_Names[id], trigrams);
+			for (auto const trigram : trigrams)
+			{
+				auto& pending{ _Postings.TryEmplace(trigram).first->Pending };
+				auto const position{ std::ranges::lower_bound(pending, id) };
+				if (position == pending.end() or *position != id)
+				{
+					pending.insert(position, id);
+					++_PendingCount;
+				}
+			}
+			CompactIfNeeded();
+		}
+
+		//Removed ids stay in the lists until the next compaction; queries skip them
+		bool Remove(std::uint32_t const id)
+		{
+			if (id >= _Live.size() or not _Live[id])
+				return false;
+			_Live[id] = 0;
+			std::string{}.swap(_Names[id]);
+			--_LiveCount;
+			++_DeadCount;
+			CompactIfNeeded();
+			return true;
+		}
+
+		//Merge the uncompressed additions into the compressed lists and drop removed ids,
+		//as well as the trigrams of the previous name of an id that was added again
+		void Compact()
+		{
+			std::vector<std::uint32_t> decoded;
+			std::vector<std::uint32_t> merged;
+			std::vector<std::uint32_t> emptyLists;
+			_CompressedCount = 0;
+			_Postings.ForEach([&](std::uint32_t const trigram, Postings& postings) {
+				postings.Compressed.Decode(decoded);
+				merged.clear();
+				std::ranges::set_union(decoded, postings.Pending, std::back_inserter(merged));
+				std::erase_if(merged, [&](std::uint32_t const id) { return not _Live[id] or (_Renamed[id] and not Contains(_Names[id], trigram)); });
+				postings.Compressed = PostingList{ merged };
+				std::vector<std::uint32_t>{}.swap(postings.Pending);
+				_CompressedCount += merged.size();
+				if (merged.empty())
+					emptyLists.push_back(trigram);
+			});
+			for (auto const trigram : emptyLists)
+				_Postings.Erase(trigram);
+			std::ranges::fill(_Renamed, 0);
+			_PendingCount = 0;
+			_DeadCount = 0;
+		}
+
+		//Ids of the names that contain text (ASCII case-insensitive), ascending
+		std::vector<std::uint32_t> Search(std::string_view const text) const
+		{
+			std::string const query{ Fold(text) };
+			std::vector<std::uint32_t> result;
+			if (query.size() < 3)
+			{
+				//No trigram to look up: verify every name
+				for (std::uint32_t id = 0; id < _Names.size(); ++id)
+					if (_Live[id] and _Names[id].find(query) != std::string::npos)
+						result.push_back(id);
+				return result;
+			}
+
+			std::vector<std::uint32_t> trigrams;
+			Trigrams(query, trigrams);
+			std::vector<Postings const*> lists;
+			for (auto const trigram : trigrams)
+			{
+				auto const* postings{ _Postings.Find(trigram) };
+				if (postings == nullptr)
+					return result;
+				lists.push_back(postings);
+			}
+			//Shortest list first: every intersection can only shrink the candidates
+			std::ranges::sort(lists, {}, [](Postings const* postings) { return postings->Size(); });
+
+			std::vector<std::uint32_t> candidates;
+			std::vector<std::uint32_t> listIds;
+			std::vector<std::uint32_t> scratch;
+			std::vector<std::uint32_t> next;
+			Materialize(*lists.front(), candidates, scratch);
+			for (std::size_t l = 1; l < lists.size() and not candidates.empty(); ++l)
+			{
+				Postings const& postings{ *lists[l] };
+				if (candidates.size() * 16 < postings.Size())
+				{
+					postings.Compressed.IntersectSparse(candidates, next);
+					if (not postings.Pending.empty())
+					{
+						Intersect(candidates, postings.Pending, scratch);
+						std::vector<std::uint32_t> both;
+						std::ranges::set_union(next, scratch, std::back_inserter(both));
+						next.swap(both);
+					}
+				}
+				else
+				{
+					Materialize(postings, listIds, scratch);
+					Intersect(candidates, listIds, next);
+				}
+				candidates.swap(next);
+			}
+
+			//Trigrams match, the substring may still not: check the names
+			for (auto const id : candidates)
+				if (_Live[id] and _Names[id].find(query) != std::string::npos)
+					result.push_back(id);
+			return result;
+		}
+
+		std::size_t Size() const noexcept { return _LiveCount; }
+
+		std::size_t TrigramCount() const noexcept { return _Postings.Size(); }
+
+		//Memory of the compressed and the pending lists
+		std::size_t PostingBytes() const
+		{
+			std::size_t bytes{ _Postings.ByteSize() };
+			_Postings.ForEach([&bytes](std::uint32_t, Postings const& postings) {
+				bytes += postings.Compressed.ByteSize() + postings.Pending.capacity() * sizeof(std::uint32_t);
+			});
+			return bytes;
+		}
+
+		//Ids in the lists (compressed + pending), for comparison with 4 bytes per uncompressed id
+		std::size_t PostingCount() const noexcept { return _CompressedCount + _PendingCount; }
+
+	private:
+		struct Postings
+		{
+			PostingList Compressed;
+			std::vector<std::uint32_t> Pending; //sorted additions since the last compaction
+
+			std::size_t Size() const noexcept { return Compressed.Size() + Pending.size(); }
+		};
+
+		static std::string Fold(std::string_view const text)
+		{
+			std::string folded{ text };
+			for (auto& c : folded)
+				if (c >= 'A' and c <= 'Z')
+					c = static_cast<char>(c - 'A' + 'a');
+			return folded;
+		}
+
+		//Distinct trigrams of a folded text
+		static void Trigrams(std::string_view const text, std::vector<std::uint32_t>& out)
+		{
+			out.clear();
+			for (std::size_t i = 0; i + 3 <= text.size(); ++i)
+				out.push_back(std::uint32_t{ static_cast<std::uint8_t>(text[i]) } << 16 | std::uint32_t{ static_cast<std::uint8_t>(text[i + 1]) } << 8 | static_cast<std::uint8_t>(text[i + 2]));
+			std::ranges::sort(out);
+			out.erase(std::unique(out.begin(), out.end()), out.end());
+		}
+
+		static bool Contains(std::string_view const text, std::uint32_t const trigram)
+		{
+			char const bytes[3]{ static_cast<char>(trigram >> 16), static_cast<char>(trigram >> 8), static_cast<char>(trigram) };
+			return text.find(std::string_view{ bytes, 3 }) != std::string_view::npos;
+		}
+
+		static void Materialize(Postings const& postings, std::vector<std::uint32_t>& out, std::vector<std::uint32_t>& scratch)
+		{
+			postings.Compressed.Decode(out);
+			if (postings.Pending.empty())
+				return;
+			scratch.clear();
+			std::ranges::set_union(out, postings.Pending, std::back_inserter(scratch));
+			out.swap(scratch);
+		}
+
+		//Keep the uncompressed additions and the removed ids below 1/8 of the index
+		void CompactIfNeeded()
+		{
+			std::size_t const limit{ std::max<std::size_t>(1 << 16, _CompressedCount / 8) };
+			if (_PendingCount > limit or _DeadCount > std::max<std::size_t>(1 << 12, _LiveCount / 8))
+				Compact();
+		}
+
+		Containers::SwissMap<std::uint32_t, Postings> _Postings;
+		std::vector<std::string> _Names;	//folded names by id, for verification
+		std::vector<std::uint8_t> _Live;
+		std::vector<std::uint8_t> _Renamed;	//added again since the last compaction
+		std::size_t _LiveCount{ 0 };
+		std::size_t _DeadCount{ 0 };
+		std::size_t _CompressedCount{ 0 };
+		std::size_t _PendingCount{ 0 };
+	};
+}
@@ -34,3 +34,21 @@
 #include <typeinfo>
 #include <ios>
 #include <array>
+#include <random>
+#include <cstring>
+#include <limits>
+#include <atomic>
+#include <optional>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <future>
+#include <fstream>
+#include <shared_mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <map>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif